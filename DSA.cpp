@@ -1,138 +1,1803 @@
 #include "project.cpp"
+#include "concurrent_leaderboard.cpp"
+#include "versioned_leaderboard.cpp"
+#include "sharded_leaderboard.cpp"
+#include "query_batch.cpp"
+#include "leaderboard_snapshot.cpp"
+#include "write_ahead_log.cpp"
+#include "stream_ingest.cpp"
+#include "sliding_window_leaderboard.cpp"
+#include "golden_model.cpp"
+#include <algorithm>
+#include <climits>
 #include <cassert>
 #include <iostream>
 #include <vector>
 #include <iomanip>
+#include <thread>
+#include <unordered_map>
 using namespace std;
 
-// ================= Golden Model =================
-class golden_model {
-public:
-    void add_player(const player_data &p) { players.push_back(p); }
+// ================= Helper Functions =================
+void print_player(const string &label, const player_data &p) {
+    cout << setw(25) << left << label
+         << " | Score: " << setw(4) << p.score
+         << " PlayerID: " << setw(3) << p.player_id
+         << " Time: " << setw(3) << p.finish_time << endl;
+}
+
+bool check_results(const player_data &actual,
+                   const player_data &expected,
+                   int &correctCount, int &totalCount) {
+    totalCount++;
+    bool pass = (actual.score == expected.score &&
+                 actual.player_id == expected.player_id &&
+                 actual.finish_time == expected.finish_time);
+    if (pass) {
+        correctCount++;
+        cout << "[PASS] "<< endl;
+    } else {
+        cout << "[FAIL] " << endl;
+        cout << "   Expected -> ";
+        print_player("", expected);
+        cout << "   Got      -> ";
+        print_player("", actual);
+    }
+    return pass;
+}
+
+void check_bool(bool actual, bool expected,
+                int &correctCount, int &totalCount) {
+    totalCount++;
+    if (actual == expected) {
+        correctCount++;
+        cout << "[PASS] " << endl;
+    } else {
+        cout << "[FAIL] " << " Expected=" << expected << " Got=" << actual << endl;
+    }
+}
+
+void check_list(const vector<player_data> &actual,
+                const vector<player_data> &expected,
+                int &correctCount, int &totalCount) {
+    bool same = actual.size() == expected.size();
+    for (size_t i = 0; same && i < actual.size(); ++i) {
+        same = actual[i].score == expected[i].score &&
+               actual[i].player_id == expected[i].player_id &&
+               actual[i].finish_time == expected[i].finish_time;
+    }
+    if (same) {
+        totalCount++;
+        correctCount++;
+        cout << "[PASS] " << endl;
+        return;
+    }
+    cout << "[FAIL] list of " << actual.size() << ", expected " << expected.size() << endl;
+    for (size_t i = 0; i < actual.size() || i < expected.size(); ++i) {
+        check_results(i < actual.size() ? actual[i] : player_data(),
+                      i < expected.size() ? expected[i] : player_data(),
+                      correctCount, totalCount);
+    }
+}
+
+// ================= Ranking Order Test =================
+// the ordering spelled out as a chain of returns , best_player must agree on the extremes of the int range
+// empty slots are the player_id -1 sentinel , a score of -1 is an ordinary score
+player_data reference_best_player(const player_data &a, const player_data &b) {
+    if (a.player_id == -1 && b.player_id == -1) return player_data();
+    if (a.player_id == -1) return b;
+    if (b.player_id == -1) return a;
+    if (a.score != b.score) return a.score > b.score ? a : b;
+    if (a.finish_time != b.finish_time) return a.finish_time < b.finish_time ? a : b;
+    return a.player_id > b.player_id ? a : b;
+}
+
+void ranking_order_test(int num_pairs, int &total_count, int &correct_count) {
+    cout << "\n--- Ranking Order Test: " << num_pairs << " pairs ---" << endl;
+
+    // extremes of the int range and -1 mixed with ordinary values , now and then an empty slot
+    const int values[] = {-2147483647 - 1, -5, -1, 0, 1, 7, 999, 2147483647};
+    for (int i = 0; i < num_pairs; ++i) {
+        player_data a(values[rand() % 8], rand() % 1000, values[rand() % 8]);
+        player_data b(values[rand() % 8], rand() % 1000, values[rand() % 8]);
+        if (a.player_id == b.player_id) b.player_id++;
+        if (rand() % 8 == 0) a = player_data();
+        if (rand() % 8 == 0) b = player_data();
+
+        player_data expected = reference_best_player(a, b);
+        player_data actual = player_data::best_player(a, b);
+        // two empty slots : any empty slot is a correct answer
+        if (expected.player_id == -1) {
+            check_bool(actual.player_id == -1, true, correct_count, total_count);
+        } else {
+            check_results(actual, expected, correct_count, total_count);
+        }
+
+        // the stored key of flat_segment_tree : same order , and it gives the player back
+        check_bool(pack_player(a) > pack_player(b), player_data::ranks_higher(a, b), correct_count, total_count);
+        if (a.player_id != -1) check_results(unpack_player(pack_player(a)), a, correct_count, total_count);
+    }
+}
+
+// ================= Stress Test =================
+// Tree is any backend with the segment_tree interface (segment_tree , flat_segment_tree)
+template <class Tree>
+void stress_test(int num_players, int num_queries,
+                 int &total_count, int &correct_count) {
+    cout << "\n--- Stress Test: " << num_players
+         << " players, " << num_queries << " queries ---" << endl;
+
+    Tree leaderboard(num_players);
+    golden_model model;
+
+    // Insert players
+    for (int i = 0; i < num_players; ++i) {
+        int score = rand() % 1000;
+        int finish_time = rand() % 1000;
+        player_data p(score, i, finish_time);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    // Query by time
+    for (int i = 0; i < num_queries; ++i) {
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        //invalid ranges in the main
+        if (t1 > t2) swap(t1, t2);
+
+        player_data actual = leaderboard.query_the_tree_by_time(t1, t2);
+        player_data expected = model.query_by_time(t1, t2);
+        check_results(actual, expected, correct_count, total_count);
+    }
+
+    // Query by ID
+    for (int i = 0; i < num_queries; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        //invalid ranges in the main
+        if (id1 > id2) swap(id1, id2);
+
+        player_data actual = leaderboard.query_the_tree_by_id(id1, id2);
+        player_data expected = model.query_by_id(id1, id2);
+        check_results(actual, expected, correct_count, total_count);
+    }
+
+    // Random updates
+    for (int i = 0; i < num_queries; ++i) {
+        int id = rand() % num_players;
+        player_data new_p(rand() % 1000, id, rand() % 1000);
+        bool act = leaderboard.update_player_data(new_p);
+        bool exp = model.update_player(new_p);
+        check_bool(act, exp,
+                   correct_count, total_count);
+    }
+}
+
+// ================= Time Index Test =================
+// updates move players between finish times , every time query after them must still match the golden model
+void time_index_test(int num_players, int num_ops,
+                     int &total_count, int &correct_count) {
+    cout << "\n--- Time Index Test: " << num_players
+         << " players, " << num_ops << " update/query rounds ---" << endl;
+
+    segment_tree leaderboard(num_players);
+    golden_model model;
+
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 100);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    for (int i = 0; i < num_ops; ++i) {
+        player_data new_p(rand() % 1000, rand() % num_players, rand() % 100);
+        leaderboard.update_player_data(new_p);
+        model.update_player(new_p);
+
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2),
+                      model.query_by_time(t1, t2),
+                      correct_count, total_count);
+    }
+}
+
+// ================= Bulk Load Test =================
+// build_from must give the same board as inserting the roster one player at a time
+template <class Tree>
+void bulk_load_test(int num_players, int num_queries,
+                    int &total_count, int &correct_count) {
+    cout << "\n--- Bulk Load Test: " << num_players
+         << " players, " << num_queries << " queries ---" << endl;
+
+    vector<player_data> roster;
+    for (int i = 0; i < num_players; ++i) {
+        // the caller's ids are replaced with reached_index , exactly as insert_into_tree does
+        roster.push_back(player_data(rand() % 1000, -1, rand() % 1000));
+    }
+
+    Tree sequential(num_players + 3);
+    Tree bulk(num_players + 3);
+    for (int i = 0; i < num_players; ++i) {
+        sequential.insert_into_tree(roster[i]);
+    }
+    bulk.build_from(roster.data(), num_players);
+
+    // the same roster appended in uneven chunks , as a streaming loader does
+    Tree chunked(num_players + 3);
+    for (int i = 0, step = 1; i < num_players; i += step, step = step * 3 % 211 + 1) {
+        chunked.build_from(roster.data() + i, min(step, num_players - i));
+    }
+
+    for (int i = 0; i < num_queries; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        check_results(bulk.query_the_tree_by_id(id1, id2),
+                      sequential.query_the_tree_by_id(id1, id2),
+                      correct_count, total_count);
+        check_results(chunked.query_the_tree_by_id(id1, id2),
+                      sequential.query_the_tree_by_id(id1, id2),
+                      correct_count, total_count);
+
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        check_results(bulk.query_the_tree_by_time(t1, t2),
+                      sequential.query_the_tree_by_time(t1, t2),
+                      correct_count, total_count);
+        check_results(chunked.query_the_tree_by_time(t1, t2),
+                      sequential.query_the_tree_by_time(t1, t2),
+                      correct_count, total_count);
+    }
+
+    // the bulk loaded board keeps growing and updating like any other
+    player_data extra(5000, -1, 1);
+    bulk.insert_into_tree(extra);
+    sequential.insert_into_tree(extra);
+    check_results(bulk.query_the_tree_by_id(0, num_players),
+                  sequential.query_the_tree_by_id(0, num_players),
+                  correct_count, total_count);
+    player_data upd(6000, num_players / 2, 2);
+    check_bool(bulk.update_player_data(upd),
+               sequential.update_player_data(upd),
+               correct_count, total_count);
+    check_results(bulk.query_the_tree_by_time(0, 5),
+                  sequential.query_the_tree_by_time(0, 5),
+                  correct_count, total_count);
+}
+
+// ================= Batch Update Test =================
+// a batch with duplicate ids and invalid ids must end in the same state as applying it one update at a time
+template <class Tree>
+void batch_update_test(int num_players, int batch_size,
+                       int &total_count, int &correct_count) {
+    cout << "\n--- Batch Update Test: " << num_players
+         << " players, batches of " << batch_size << " ---" << endl;
+
+    Tree leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    for (int round = 0; round < 5; ++round) {
+        vector<player_data> batch;
+        for (int i = 0; i < batch_size; ++i) {
+            // small id range so the batch is full of repeated players
+            batch.push_back(player_data(rand() % 1000, rand() % (num_players / 10), rand() % 1000));
+        }
+        batch.push_back(player_data(10, num_players + 5, 10));
+
+        vector<bool> results = leaderboard.apply_updates(batch);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            check_bool(results[i], model.update_player(batch[i]), correct_count, total_count);
+        }
+
+        for (int i = 0; i < 20; ++i) {
+            int id1 = rand() % num_players, id2 = rand() % num_players;
+            if (id1 > id2) swap(id1, id2);
+            check_results(leaderboard.query_the_tree_by_id(id1, id2),
+                          model.query_by_id(id1, id2),
+                          correct_count, total_count);
+
+            int t1 = rand() % 1000, t2 = rand() % 1000;
+            if (t1 > t2) swap(t1, t2);
+            check_results(leaderboard.query_the_tree_by_time(t1, t2),
+                          model.query_by_time(t1, t2),
+                          correct_count, total_count);
+        }
+    }
+}
+
+// ================= Top K Test =================
+template <class Tree>
+void top_k_test(int num_players, int num_queries,
+                int &total_count, int &correct_count) {
+    cout << "\n--- Top K Test: " << num_players
+         << " players, " << num_queries << " queries ---" << endl;
+
+    Tree leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        // narrow score and time ranges so the tie-break rules decide the order
+        player_data p(rand() % 50, i, rand() % 50);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+    const int ks[] = {1, 10, 50, 100};
+
+    for (int i = 0; i < num_queries; ++i) {
+        int k = ks[i % 4];
+        player_data new_p(rand() % 50, rand() % num_players, rand() % 50);
+        leaderboard.update_player_data(new_p);
+        model.update_player(new_p);
+
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        check_list(leaderboard.top_k_by_id(id1, id2, k),
+                   model.top_k_by_id(id1, id2, k),
+                   correct_count, total_count);
+
+        int t1 = rand() % 50, t2 = rand() % 50;
+        if (t1 > t2) swap(t1, t2);
+        check_list(leaderboard.top_k_by_time(t1, t2, k),
+                   model.top_k_by_time(t1, t2, k),
+                   correct_count, total_count);
+    }
+}
+
+// ================= ID and Time Test =================
+// combined queries before and after the 2D index exists , across inserts , single updates and batches
+template <class Tree>
+void id_time_test(int num_players, int num_queries,
+                  int &total_count, int &correct_count) {
+    cout << "\n--- ID and Time Test: " << num_players
+         << " players, " << num_queries << " queries ---" << endl;
+
+    Tree leaderboard(num_players);
+    golden_model model;
+    vector<player_data> roster;
+    for (int i = 0; i < num_players / 2; ++i) {
+        roster.push_back(player_data(rand() % 1000, i, rand() % 1000));
+        model.add_player(roster.back());
+    }
+    leaderboard.build_from(roster.data(), (int)roster.size());
+
+    int count = (int)roster.size();
+    for (int i = 0; i < num_queries; ++i) {
+        // the board keeps growing after the index is built , one player at a time and in chunks
+        if (count + 3 <= num_players) {
+            if (i % 2 == 0) {
+                player_data p(rand() % 1000, count++, rand() % 1000);
+                model.add_player(p);
+                leaderboard.insert_into_tree(p);
+            } else {
+                vector<player_data> chunk;
+                for (int j = 0; j < 3; ++j) {
+                    chunk.push_back(player_data(rand() % 1000, count++, rand() % 1000));
+                    model.add_player(chunk.back());
+                }
+                leaderboard.build_from(chunk.data(), (int)chunk.size());
+            }
+        }
+
+        player_data new_p(rand() % 1000, rand() % count, rand() % 1000);
+        leaderboard.update_player_data(new_p);
+        model.update_player(new_p);
+
+        vector<player_data> batch;
+        for (int j = 0; j < 4; ++j) batch.push_back(player_data(rand() % 1000, rand() % count, rand() % 1000));
+        leaderboard.apply_updates(batch);
+        for (size_t j = 0; j < batch.size(); ++j) model.update_player(batch[j]);
+
+        int id1 = rand() % count, id2 = rand() % count;
+        if (id1 > id2) swap(id1, id2);
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_by_id_and_time(id1, id2, t1, t2),
+                      model.query_by_id_and_time(id1, id2, t1, t2),
+                      correct_count, total_count);
+    }
+}
+
+// ================= Freeze Test =================
+// a frozen board answers like the golden model and refuses changes , a thawed one takes them again
+void freeze_test(int num_players, int num_queries,
+                 int &total_count, int &correct_count) {
+    cout << "\n--- Freeze Test: " << num_players << " players, "
+         << num_queries << " queries ---" << endl;
+
+    segment_tree leaderboard(num_players + 10);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        // narrow ranges so ties decide the order
+        player_data p(rand() % 50, i, rand() % 50);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    for (int round = 0; round < 3; ++round) {
+        leaderboard.freeze();
+        check_bool(leaderboard.is_frozen() && leaderboard.frozen_memory_bytes() > 0, true,
+                   correct_count, total_count);
+        check_bool(leaderboard.update_player_data(player_data(1, 0, 1)), false, correct_count, total_count);
+
+        for (int i = 0; i < num_queries; ++i) {
+            int id1 = rand() % num_players, id2 = rand() % num_players;
+            if (id1 > id2) swap(id1, id2);
+            check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                          correct_count, total_count);
+            check_list(leaderboard.top_k_by_id(id1, id2, 10), model.top_k_by_id(id1, id2, 10),
+                       correct_count, total_count);
+            int id = rand() % num_players;
+            check_bool(leaderboard.rank_of(id) == model.rank_of(id), true, correct_count, total_count);
+
+            int t1 = rand() % 50, t2 = rand() % 50;
+            if (t1 > t2) swap(t1, t2);
+            check_results(leaderboard.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2),
+                          correct_count, total_count);
+        }
+
+        leaderboard.thaw();
+        check_bool(leaderboard.is_frozen() || leaderboard.frozen_memory_bytes() != 0, false,
+                   correct_count, total_count);
+        for (int i = 0; i < num_queries; ++i) {
+            player_data new_p(rand() % 50, rand() % num_players, rand() % 50);
+            check_bool(leaderboard.update_player_data(new_p), true, correct_count, total_count);
+            model.update_player(new_p);
+
+            int id1 = rand() % num_players, id2 = rand() % num_players;
+            if (id1 > id2) swap(id1, id2);
+            check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                          correct_count, total_count);
+        }
+    }
+}
+
+// ================= Range Add Test =================
+// range adds mixed with every other write , the ID tree , the indexes every range add moves and the frozen form all
+// have to agree with the golden model after each step
+void range_add_test(int num_players, int num_ops,
+                    int &total_count, int &correct_count) {
+    cout << "\n--- Range Add Test: " << num_players << " players, "
+         << num_ops << " operations ---" << endl;
+
+    segment_tree leaderboard(num_players);
+    golden_model model;
+    vector<player_data> roster;
+    for (int i = 0; i < num_players / 2; ++i) {
+        // narrow ranges so ties decide the order
+        roster.push_back(player_data(rand() % 100, i, rand() % 100));
+        model.add_player(roster.back());
+    }
+    leaderboard.build_from(roster.data(), (int)roster.size());
+    int count = (int)roster.size();
+
+    check_bool(leaderboard.add_score_range(0, count, 5), false, correct_count, total_count);
+    check_bool(leaderboard.add_score_range(3, 2, 5), false, correct_count, total_count);
+
+    for (int i = 0; i < num_ops; ++i) {
+        // short ranges move player by player in the indexes , long ones rebuild them
+        int id1 = rand() % count;
+        int id2 = i % 4 == 0 ? count - 1 : min(count - 1, id1 + rand() % 8);
+        int delta = rand() % 61 - 30;
+        check_bool(leaderboard.add_score_range(id1, id2, delta), true, correct_count, total_count);
+        model.add_score_range(id1, id2, delta);
+        // the range add only queues the shift for the indexes
+        check_bool(leaderboard.indexes_current(), delta == 0, correct_count, total_count);
+
+        switch (i % 5) {
+        case 0:
+            if (count < num_players) {
+                player_data p(rand() % 100, count++, rand() % 100);
+                model.add_player(p);
+                leaderboard.insert_into_tree(p);
+            }
+            break;
+        case 1: {
+            player_data new_p(rand() % 100, rand() % count, rand() % 100);
+            leaderboard.update_player_data(new_p);
+            model.update_player(new_p);
+            break;
+        }
+        case 2: {
+            vector<player_data> batch;
+            for (int j = 0; j < 4; ++j) batch.push_back(player_data(rand() % 100, rand() % count, rand() % 100));
+            leaderboard.apply_updates(batch);
+            for (size_t j = 0; j < batch.size(); ++j) model.update_player(batch[j]);
+            break;
+        }
+        case 3:
+            if (count + 3 <= num_players) {
+                vector<player_data> chunk;
+                for (int j = 0; j < 3; ++j) {
+                    chunk.push_back(player_data(rand() % 100, count++, rand() % 100));
+                    model.add_player(chunk.back());
+                }
+                leaderboard.build_from(chunk.data(), (int)chunk.size());
+            }
+            break;
+        default:
+            // a round trip through the frozen form keeps the shifted scores
+            leaderboard.freeze();
+            check_bool(leaderboard.add_score_range(0, 0, 1), false, correct_count, total_count);
+            check_list(leaderboard.top_k_by_id(0, count - 1, 10), model.top_k_by_id(0, count - 1, 10),
+                       correct_count, total_count);
+            leaderboard.thaw();
+            break;
+        }
+
+        int a = rand() % count, b = rand() % count;
+        if (a > b) swap(a, b);
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_id(a, b), model.query_by_id(a, b),
+                      correct_count, total_count);
+        check_list(leaderboard.top_k_by_id(a, b, 5), model.top_k_by_id(a, b, 5), correct_count, total_count);
+        // the update , the batch and the freeze always write and catch the indexes up on their way ,
+        // the other rounds may not have written
+        if (i % 5 == 1 || i % 5 == 2 || i % 5 == 4) {
+            check_bool(leaderboard.indexes_current(), true, correct_count, total_count);
+        }
+        leaderboard.sync_indexes();
+        if (i % 3 == 0) {
+            check_results(leaderboard.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2),
+                          correct_count, total_count);
+            check_list(leaderboard.top_k_by_time(t1, t2, 5), model.top_k_by_time(t1, t2, 5),
+                       correct_count, total_count);
+        }
+        if (i % 3 == 1) {
+            int id = rand() % count;
+            check_bool(leaderboard.rank_of(id) == model.rank_of(id), true, correct_count, total_count);
+            int rank = 1 + rand() % count;
+            check_results(leaderboard.player_at(rank), model.player_at(rank), correct_count, total_count);
+        }
+        if (i % 3 == 2 && i > num_ops / 2) {
+            // the combined index is built late , after many shifts , and kept in sync from then on
+            check_results(leaderboard.query_by_id_and_time(a, b, t1, t2), model.query_by_id_and_time(a, b, t1, t2),
+                          correct_count, total_count);
+        }
+    }
+}
+
+// ================= Growth Test =================
+// a board created for one player grows to thousands through inserts , appends and bulk loads ,
+// with the combined index enabled early so it has to grow along
+void growth_test(int num_players, int num_queries,
+                 int &total_count, int &correct_count) {
+    cout << "\n--- Growth Test: " << num_players << " players, "
+         << num_queries << " queries ---" << endl;
+
+    segment_tree leaderboard(1);
+    golden_model model;
+    int count = 0;
+    for (; count < 3; ++count) {
+        player_data p(rand() % 100, count, rand() % 100);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+    check_bool(leaderboard.size() == 4, true, correct_count, total_count);
+    check_results(leaderboard.query_by_id_and_time(0, 2, 0, 99), model.query_by_id_and_time(0, 2, 0, 99),
+                  correct_count, total_count);
+
+    while (count < num_players) {
+        if (count % 3 == 0) {
+            // a chunk large enough to need several doublings at once
+            vector<player_data> chunk;
+            for (int j = 0; j < count / 2 + 1 && count < num_players; ++j) {
+                chunk.push_back(player_data(rand() % 100, count++, rand() % 100));
+                model.add_player(chunk.back());
+            }
+            leaderboard.build_from(chunk.data(), (int)chunk.size());
+        } else {
+            player_data p(rand() % 100, count++, rand() % 100);
+            model.add_player(p);
+            leaderboard.insert_into_tree(p);
+        }
+        check_bool(leaderboard.last_index() == count - 1 && leaderboard.size() >= count &&
+                   leaderboard.size() < 2 * count, true, correct_count, total_count);
+
+        player_data new_p(rand() % 100, rand() % count, rand() % 100);
+        leaderboard.update_player_data(new_p);
+        model.update_player(new_p);
+
+        int id1 = rand() % count, id2 = rand() % count;
+        if (id1 > id2) swap(id1, id2);
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                      correct_count, total_count);
+        check_results(leaderboard.query_by_id_and_time(id1, id2, t1, t2),
+                      model.query_by_id_and_time(id1, id2, t1, t2), correct_count, total_count);
+    }
+
+    for (int i = 0; i < num_queries; ++i) {
+        int id1 = rand() % count, id2 = rand() % count;
+        if (id1 > id2) swap(id1, id2);
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                      correct_count, total_count);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2),
+                      correct_count, total_count);
+        check_list(leaderboard.top_k_by_id(id1, id2, 5), model.top_k_by_id(id1, id2, 5), correct_count, total_count);
+        int id = rand() % count;
+        check_bool(leaderboard.rank_of(id) == model.rank_of(id), true, correct_count, total_count);
+    }
+
+    // the frozen form and the rebuilt tree cover the grown capacity too
+    leaderboard.freeze();
+    leaderboard.thaw();
+    player_data p(rand() % 100, count++, rand() % 100);
+    model.add_player(p);
+    leaderboard.insert_into_tree(p);
+    check_results(leaderboard.query_the_tree_by_id(0, count - 1), model.query_by_id(0, count - 1),
+                  correct_count, total_count);
+}
+
+// ================= Negative Score Test =================
+// penalties take scores through -1 and below , a real player at -1 must not turn into an empty slot
+void negative_score_test(int num_players, int num_ops,
+                         int &total_count, int &correct_count) {
+    cout << "\n--- Negative Score Test: " << num_players << " players, "
+         << num_ops << " operations ---" << endl;
+
+    {
+        segment_tree leaderboard(2);
+        golden_model model;
+        player_data a(1, 0, 5), b(0, 1, 5);
+        leaderboard.insert_into_tree(a);
+        leaderboard.insert_into_tree(b);
+        model.add_player(a);
+        model.add_player(b);
+        leaderboard.add_score_range(0, 1, -2);
+        model.add_score_range(0, 1, -2);
+        check_results(leaderboard.query_the_tree_by_id(0, 1), player_data(-1, 0, 5), correct_count, total_count);
+        leaderboard.sync_indexes();
+        check_results(leaderboard.query_the_tree_by_time(0, 10), player_data(-1, 0, 5), correct_count, total_count);
+        check_bool(leaderboard.rank_of(0) == 1 && leaderboard.rank_of(1) == 2, true, correct_count, total_count);
+        check_list(leaderboard.top_k_by_id(0, 1, 2), model.top_k_by_id(0, 1, 2), correct_count, total_count);
+        check_list(leaderboard.top_k_by_time(0, 10, 2), model.top_k_by_time(0, 10, 2), correct_count, total_count);
+    }
+
+    segment_tree leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 6, i, rand() % 20);
+        leaderboard.insert_into_tree(p);
+        model.add_player(p);
+    }
+    for (int i = 0; i < num_ops; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        int delta = rand() % 7 - 4;
+        leaderboard.add_score_range(id1, id2, delta);
+        model.add_score_range(id1, id2, delta);
+        if (i % 7 == 0) {
+            player_data new_p(-1 - rand() % 3, rand() % num_players, rand() % 20);
+            leaderboard.update_player_data(new_p);
+            model.update_player(new_p);
+        }
+        if (i % 11 == 0) {
+            leaderboard.freeze();
+            check_list(leaderboard.top_k_by_id(id1, id2, 5), model.top_k_by_id(id1, id2, 5), correct_count, total_count);
+            leaderboard.thaw();
+        }
+
+        int a = rand() % num_players, b = rand() % num_players;
+        if (a > b) swap(a, b);
+        int t1 = rand() % 20, t2 = rand() % 20;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_id(a, b), model.query_by_id(a, b), correct_count, total_count);
+        leaderboard.sync_indexes();
+        check_results(leaderboard.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2), correct_count, total_count);
+        check_list(leaderboard.top_k_by_id(a, b, 5), model.top_k_by_id(a, b, 5), correct_count, total_count);
+        check_list(leaderboard.top_k_by_time(t1, t2, 5), model.top_k_by_time(t1, t2, 5), correct_count, total_count);
+        int id = rand() % num_players;
+        check_bool(leaderboard.rank_of(id) == model.rank_of(id), true, correct_count, total_count);
+        int rank = 1 + rand() % num_players;
+        check_results(leaderboard.player_at(rank), model.player_at(rank), correct_count, total_count);
+    }
+}
+
+// ================= Remove Test =================
+// players leave and slots are reused , mixed with every other write , compaction and freeze / thaw
+// the free list is mirrored here so the IDs handed out by insert_into_tree and build_from are known
+void remove_test(int num_players, int num_ops,
+                 int &total_count, int &correct_count) {
+    cout << "\n--- Remove Test: " << num_players << " players, "
+         << num_ops << " operations ---" << endl;
+
+    segment_tree leaderboard(num_players);
+    golden_model model;
+    vector<int> present, free_ids;
+    vector<bool> removed(num_players, false);
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 100, i, rand() % 100);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+        present.push_back(i);
+    }
+    int count = num_players;
+
+    for (int i = 0; i < num_ops; ++i) {
+        int choice = rand() % 10;
+        if (choice < 4 && present.size() > 1) {
+            size_t at = rand() % present.size();
+            int id = present[at];
+            present[at] = present.back();
+            present.pop_back();
+            check_bool(leaderboard.remove_player(id), true, correct_count, total_count);
+            check_bool(leaderboard.remove_player(id), false, correct_count, total_count);
+            model.remove_player(id);
+            free_ids.push_back(id);
+            removed[id] = true;
+        } else if (choice < 7) {
+            // one insert , or a short roster through build_from : both hand out the freed slots first
+            int batch = choice == 6 ? 2 + rand() % 5 : 1;
+            vector<player_data> roster;
+            for (int j = 0; j < batch; ++j) {
+                int id = count;
+                if (!free_ids.empty()) {
+                    id = free_ids.back();
+                    free_ids.pop_back();
+                    removed[id] = false;
+                } else {
+                    count++;
+                    removed.push_back(false);
+                }
+                player_data p(rand() % 100, id, rand() % 100);
+                roster.push_back(p);
+                model.add_player(p);
+                present.push_back(id);
+            }
+            if (batch == 1) leaderboard.insert_into_tree(roster[0]);
+            else leaderboard.build_from(roster.data(), batch);
+        } else if (choice == 7) {
+            int id = rand() % count;
+            player_data new_p(rand() % 100, id, rand() % 100);
+            check_bool(leaderboard.update_player_data(new_p), !removed[id], correct_count, total_count);
+            model.update_player(new_p);
+
+            vector<player_data> batch;
+            for (int j = 0; j < 4; ++j) batch.push_back(player_data(rand() % 100, rand() % count, rand() % 100));
+            vector<bool> ok = leaderboard.apply_updates(batch);
+            for (size_t j = 0; j < batch.size(); ++j) {
+                check_bool(ok[j], !removed[batch[j].player_id], correct_count, total_count);
+                model.update_player(batch[j]);
+            }
+        } else if (choice == 8) {
+            int id1 = rand() % count, id2 = rand() % count;
+            if (id1 > id2) swap(id1, id2);
+            int delta = rand() % 21 - 10;
+            leaderboard.add_score_range(id1, id2, delta);
+            model.add_score_range(id1, id2, delta);
+            leaderboard.sync_indexes(); // time reads follow
+        } else if (i % 3 == 0) {
+            leaderboard.compact();
+        } else {
+            leaderboard.freeze();
+            check_bool(leaderboard.remove_player(present[0]), false, correct_count, total_count);
+            check_list(leaderboard.top_k_by_id(0, count - 1, 10), model.top_k_by_id(0, count - 1, 10),
+                       correct_count, total_count);
+            leaderboard.thaw();
+        }
+
+        check_bool(leaderboard.player_count() == (int)present.size() && leaderboard.last_index() == count - 1,
+                   true, correct_count, total_count);
+        int id1 = rand() % count, id2 = rand() % count;
+        if (id1 > id2) swap(id1, id2);
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                      correct_count, total_count);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2),
+                      correct_count, total_count);
+        if (i % 4 == 0) {
+            check_list(leaderboard.top_k_by_id(id1, id2, 5), model.top_k_by_id(id1, id2, 5),
+                       correct_count, total_count);
+            check_list(leaderboard.top_k_by_time(t1, t2, 5), model.top_k_by_time(t1, t2, 5),
+                       correct_count, total_count);
+            int id = rand() % count;
+            check_bool(leaderboard.rank_of(id) == model.rank_of(id), true, correct_count, total_count);
+            int rank = 1 + rand() % (int)present.size();
+            check_results(leaderboard.player_at(rank), model.player_at(rank), correct_count, total_count);
+        }
+        if (i % 4 == 2 && i > num_ops / 3) {
+            check_results(leaderboard.query_by_id_and_time(id1, id2, t1, t2),
+                          model.query_by_id_and_time(id1, id2, t1, t2), correct_count, total_count);
+        }
+    }
+
+    // removed slots survive a snapshot , the restored board hands them out again
+    const string path = "dsa_remove_snapshot.bin";
+    check_bool(save_snapshot(leaderboard, path), true, correct_count, total_count);
+    mapped_leaderboard mapped(path);
+    segment_tree restored(mapped.size());
+    mapped.restore_into(restored);
+    check_bool(restored.player_count() == (int)present.size(), true, correct_count, total_count);
+    for (int i = 0; i < 100; ++i) {
+        int id1 = rand() % count, id2 = rand() % count;
+        if (id1 > id2) swap(id1, id2);
+        check_results(restored.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                      correct_count, total_count);
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_results(mapped.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2),
+                      correct_count, total_count);
+    }
+    if (!free_ids.empty()) {
+        restored.insert_into_tree(player_data(1000, -1, 0));
+        check_bool(restored.last_index() == count - 1 && restored.player_count() == (int)present.size() + 1, true,
+                   correct_count, total_count);
+    }
+    remove(path.c_str());
+}
+
+// ================= External ID Test =================
+// the flat map against std::unordered_map through heavy insert / erase churn , then a board driven only by
+// external IDs , with removals handing slots to new accounts , so slot order and external ID order drift apart
+void external_id_test(int num_players, int num_ops,
+                      int &total_count, int &correct_count) {
+    cout << "\n--- External ID Test: " << num_players << " players, "
+         << num_ops << " operations ---" << endl;
+
+    external_id_map map;
+    unordered_map<long long, int> expected;
+    for (int i = 0; i < num_ops * 4; ++i) {
+        // a small key space keeps hitting present keys and tombstones
+        long long key = ((long long)(rand() % (num_players * 2)) << 33) - (rand() % 3);
+        if (rand() % 3 == 0) {
+            check_bool(map.erase(key), expected.erase(key) == 1, correct_count, total_count);
+        } else {
+            bool fresh = expected.find(key) == expected.end();
+            if (fresh) expected[key] = i;
+            check_bool(map.insert(key, i), fresh, correct_count, total_count);
+        }
+        long long probe = ((long long)(rand() % (num_players * 2)) << 33) - (rand() % 3);
+        unordered_map<long long, int>::iterator it = expected.find(probe);
+        check_bool(map.find(probe) == (it == expected.end() ? -1 : it->second), true, correct_count, total_count);
+    }
+    check_bool(map.size() == expected.size(), true, correct_count, total_count);
+
+    segment_tree leaderboard(16);
+    golden_model model;
+    vector<long long> accounts;
+    unordered_map<long long, int> slots;
+    long long next_account = 9000000000000LL;
+    for (int i = 0; i < num_players; ++i) {
+        long long account = next_account += 1 + rand() % 1000;
+        player_data p(rand() % 100, -1, rand() % 100);
+        int slot = leaderboard.insert_with_external_id(account, p);
+        check_bool(slot == i, true, correct_count, total_count);
+        model.add_player(player_data(p.score, slot, p.finish_time));
+        accounts.push_back(account);
+        slots[account] = slot;
+    }
+    check_bool(leaderboard.insert_with_external_id(accounts[0], player_data(1, -1, 1)) == -1, true,
+               correct_count, total_count);
+
+    for (int i = 0; i < num_ops; ++i) {
+        size_t at = rand() % accounts.size();
+        long long account = accounts[at];
+        if (i % 5 == 0 && accounts.size() > 1) {
+            // the account leaves , a new one takes its slot
+            int slot = slots[account];
+            check_bool(leaderboard.remove_player(slot), true, correct_count, total_count);
+            model.remove_player(slot);
+            check_bool(leaderboard.slot_of_external_id(account) == -1, true, correct_count, total_count);
+            check_bool(leaderboard.update_by_external_id(account, 1, 1), false, correct_count, total_count);
+            slots.erase(account);
+            accounts[at] = accounts.back();
+            accounts.pop_back();
+
+            long long fresh = next_account += 1 + rand() % 1000;
+            player_data p(rand() % 100, -1, rand() % 100);
+            check_bool(leaderboard.insert_with_external_id(fresh, p) == slot, true, correct_count, total_count);
+            model.add_player(player_data(p.score, slot, p.finish_time));
+            accounts.push_back(fresh);
+            slots[fresh] = slot;
+            continue;
+        }
+
+        if (i % 7 == 3) {
+            // the update below catches the external ID order up with the range add
+            int id1 = rand() % num_players, id2 = rand() % num_players;
+            if (id1 > id2) swap(id1, id2);
+            int delta = rand() % 21 - 10;
+            leaderboard.add_score_range(id1, id2, delta);
+            model.add_score_range(id1, id2, delta);
+        }
+
+        int score = rand() % 100, finish_time = rand() % 100;
+        check_bool(leaderboard.update_by_external_id(account, score, finish_time), true, correct_count, total_count);
+        model.update_player(player_data(score, slots[account], finish_time));
+
+        // the accounts in [a , b] , any end point , present or not
+        long long a = accounts[rand() % accounts.size()] - rand() % 3, b = accounts[rand() % accounts.size()] + rand() % 3;
+        if (a > b) swap(a, b);
+        player_data expected_best;
+        for (size_t j = 0; j < accounts.size(); ++j) {
+            if (accounts[j] >= a && accounts[j] <= b) {
+                expected_best = player_data::best_player(expected_best, model.query_by_id(slots[accounts[j]], slots[accounts[j]]));
+            }
+        }
+        check_results(leaderboard.query_by_external_id_range(a, b), expected_best, correct_count, total_count);
+    }
+    check_results(leaderboard.query_by_external_id_range(-5, 0), player_data(), correct_count, total_count);
+    check_results(leaderboard.query_by_external_id_range(accounts[0], accounts[0] - 1), player_data(),
+                  correct_count, total_count);
+}
+
+// ================= Multi Aggregate Test =================
+// one query_range answer against the golden model , the best player and every aggregate at once
+void check_summary(const range_summary<dashboard_aggregates> &actual,
+                   const range_summary<dashboard_aggregates> &expected,
+                   int &correct_count, int &total_count) {
+    check_results(actual.best, expected.best, correct_count, total_count);
+    check_bool(actual.count == expected.count && actual.total == expected.total &&
+               actual.earliest == expected.earliest && actual.mean() == expected.mean(), true,
+               correct_count, total_count);
+}
+
+// a board keeping count , total score and earliest finish per node through every write , the lazy range
+// adds shift the totals of whole subtrees , removed slots must drop out of every aggregate
+void multi_aggregate_test(int num_players, int num_ops,
+                          int &total_count, int &correct_count) {
+    cout << "\n--- Multi Aggregate Test: " << num_players << " players, "
+         << num_ops << " operations ---" << endl;
+
+    basic_segment_tree<dashboard_aggregates> leaderboard(16);
+    golden_model model;
+    vector<player_data> roster;
+    for (int i = 0; i < num_players / 2; ++i) {
+        roster.push_back(player_data(rand() % 100, i, rand() % 100));
+        model.add_player(roster.back());
+    }
+    leaderboard.build_from(roster.data(), (int)roster.size());
+    int count = (int)roster.size();
+    vector<bool> removed(count, false);
+    vector<int> free_ids;
+
+    check_summary(leaderboard.query_range(0, count), range_summary<dashboard_aggregates>(), correct_count, total_count);
+    check_summary(leaderboard.query_range_by_time(5, -1), range_summary<dashboard_aggregates>(),
+                  correct_count, total_count);
+
+    for (int i = 0; i < num_ops; ++i) {
+        switch (i % 6) {
+        case 0: {
+            int id = count;
+            if (!free_ids.empty()) {
+                id = free_ids.back();
+                free_ids.pop_back();
+                removed[id] = false;
+            } else {
+                count++;
+                removed.push_back(false);
+            }
+            player_data p(rand() % 100, id, rand() % 100);
+            leaderboard.insert_into_tree(p);
+            model.add_player(p);
+            break;
+        }
+        case 1: {
+            player_data new_p(rand() % 100, rand() % count, rand() % 100);
+            leaderboard.update_player_data(new_p);
+            model.update_player(new_p);
+            vector<player_data> batch;
+            for (int j = 0; j < 4; ++j) batch.push_back(player_data(rand() % 100, rand() % count, rand() % 100));
+            leaderboard.apply_updates(batch);
+            for (size_t j = 0; j < batch.size(); ++j) model.update_player(batch[j]);
+            break;
+        }
+        case 2: {
+            int id1 = rand() % count, id2 = rand() % count;
+            if (id1 > id2) swap(id1, id2);
+            int delta = rand() % 41 - 20;
+            leaderboard.add_score_range(id1, id2, delta);
+            model.add_score_range(id1, id2, delta);
+            leaderboard.sync_indexes();
+            break;
+        }
+        case 3: {
+            int id = rand() % count;
+            if (!removed[id] && leaderboard.remove_player(id)) {
+                model.remove_player(id);
+                removed[id] = true;
+                free_ids.push_back(id);
+            }
+            if (i % 4 == 3) leaderboard.compact();
+            break;
+        }
+        case 4: {
+            // build_from refills the freed slots before it appends
+            vector<player_data> chunk;
+            for (int j = 0; j < 3; ++j) {
+                int id = count;
+                if (!free_ids.empty()) {
+                    id = free_ids.back();
+                    free_ids.pop_back();
+                    removed[id] = false;
+                } else {
+                    count++;
+                    removed.push_back(false);
+                }
+                chunk.push_back(player_data(rand() % 100, id, rand() % 100));
+                model.add_player(chunk.back());
+            }
+            leaderboard.build_from(chunk.data(), (int)chunk.size());
+            break;
+        }
+        default: {
+            // the frozen form keeps its own heap of aggregates , thaw rebuilds them in the tree
+            leaderboard.freeze();
+            for (int j = 0; j < 4; ++j) {
+                int id1 = rand() % count, id2 = j == 0 ? id1 : rand() % count;
+                if (id1 > id2) swap(id1, id2);
+                check_summary(leaderboard.query_range(id1, id2), model.summary_by_id(id1, id2),
+                              correct_count, total_count);
+            }
+            check_summary(leaderboard.query_range(0, count - 1), model.summary_by_id(0, count - 1),
+                          correct_count, total_count);
+            leaderboard.thaw();
+            break;
+        }
+        }
+
+        int id1 = rand() % count, id2 = rand() % count;
+        if (id1 > id2) swap(id1, id2);
+        int t1 = rand() % 100, t2 = rand() % 100;
+        if (t1 > t2) swap(t1, t2);
+        check_summary(leaderboard.query_range(id1, id2), model.summary_by_id(id1, id2), correct_count, total_count);
+        check_summary(leaderboard.query_range_by_time(t1, t2), model.summary_by_time(t1, t2),
+                      correct_count, total_count);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                      correct_count, total_count);
+    }
+    check_summary(leaderboard.query_range(0, count - 1), model.summary_by_id(0, count - 1), correct_count, total_count);
+}
+
+// ================= Rank Test =================
+template <class Tree>
+void rank_test(int num_players, int num_queries,
+               int &total_count, int &correct_count) {
+    cout << "\n--- Rank Test: " << num_players
+         << " players, " << num_queries << " queries ---" << endl;
+
+    Tree leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 100, i, rand() % 100);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    for (int i = 0; i < num_queries; ++i) {
+        player_data new_p(rand() % 100, rand() % num_players, rand() % 100);
+        leaderboard.update_player_data(new_p);
+        model.update_player(new_p);
+
+        int id = rand() % num_players;
+        check_bool(leaderboard.rank_of(id) == model.rank_of(id), true,
+                   correct_count, total_count);
 
-    player_data query_by_time(int start, int end) {
-        player_data best;
-        for (const auto &p : players) {
-            if (p.finish_time >= start && p.finish_time <= end) {
-                best = player_data::best_player(best, p);
+        int rank = 1 + rand() % num_players;
+        check_results(leaderboard.player_at(rank), model.player_at(rank),
+                      correct_count, total_count);
+    }
+}
+
+// ================= Concurrent Test =================
+// readers run lock free while the writer keeps publishing versions , every answer they get must be a real player
+// of the queried range , and once the writer is done the board must match the golden model
+void concurrent_test(int num_players, int num_updates, int num_readers,
+                     int &total_count, int &correct_count) {
+    cout << "\n--- Concurrent Test: " << num_players << " players, "
+         << num_updates << " updates, " << num_readers << " readers ---" << endl;
+
+    concurrent_leaderboard leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    vector<player_data> updates;
+    for (int i = 0; i < num_updates; ++i) {
+        updates.push_back(player_data(rand() % 1000, rand() % num_players, rand() % 1000));
+    }
+
+    atomic<bool> done(false);
+    atomic<int> bad_answers(0);
+    vector<thread> readers;
+    for (int r = 0; r < num_readers; ++r) {
+        readers.push_back(thread([&, r]() {
+            unsigned state = 12345u + r;
+            while (!done.load()) {
+                state = state * 1103515245u + 12345u;
+                int id1 = (state >> 8) % num_players;
+                int id2 = id1 + (int)((state >> 4) % (num_players - id1));
+                player_data by_id = leaderboard.query_the_tree_by_id(id1, id2);
+                if (by_id.player_id < id1 || by_id.player_id > id2) bad_answers++;
+
+                int t1 = (state >> 12) % 500;
+                player_data by_time = leaderboard.query_the_tree_by_time(t1, t1 + 500);
+                if (by_time.score != -1 && (by_time.finish_time < t1 || by_time.finish_time > t1 + 500)) bad_answers++;
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < updates.size(); ++i) {
+        leaderboard.update_player_data(updates[i]);
+        model.update_player(updates[i]);
+    }
+    done.store(true);
+    for (size_t r = 0; r < readers.size(); ++r) readers[r].join();
+
+    check_bool(bad_answers.load() == 0, true, correct_count, total_count);
+    for (int i = 0; i < 100; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2),
+                      model.query_by_id(id1, id2),
+                      correct_count, total_count);
+
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2),
+                      model.query_by_time(t1, t2),
+                      correct_count, total_count);
+    }
+}
+
+// ================= Query Batch Test =================
+// rounds of updates , each followed by one mixed burst answered on the pool , answers must come back in input order
+template <class Tree>
+void query_batch_test(int num_players, int num_rounds, int batch_size,
+                      int &total_count, int &correct_count) {
+    cout << "\n--- Query Batch Test: " << num_players << " players, "
+         << num_rounds << " rounds of " << batch_size << " queries ---" << endl;
+
+    Tree leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    thread_pool pool(4);
+    for (int r = 0; r < num_rounds; ++r) {
+        for (int i = 0; i < 50; ++i) {
+            player_data new_p(rand() % 1000, rand() % num_players, rand() % 1000);
+            leaderboard.update_player_data(new_p);
+            model.update_player(new_p);
+        }
+
+        vector<range_query> queries;
+        vector<player_data> expected;
+        for (int i = 0; i < batch_size; ++i) {
+            int low = rand() % num_players, high = rand() % num_players;
+            if (low > high) swap(low, high);
+            if (rand() % 2) {
+                queries.push_back(range_query(by_id, low, high));
+                expected.push_back(model.query_by_id(low, high));
+            } else {
+                low %= 1000; high %= 1000;
+                if (low > high) swap(low, high);
+                queries.push_back(range_query(by_time, low, high));
+                expected.push_back(model.query_by_time(low, high));
             }
         }
-        return best;
+
+        vector<player_data> results = query_batch(pool, leaderboard, queries);
+        check_bool(results.size() == expected.size(), true, correct_count, total_count);
+        for (size_t i = 0; i < results.size() && i < expected.size(); ++i) {
+            check_results(results[i], expected[i], correct_count, total_count);
+        }
+    }
+}
+
+// a burst straight after range adds : the writer catches the indexes up before handing the board to the pool ,
+// so the pool threads only ever read , short ranges move players one by one , long ones rebuild the indexes
+void range_add_batch_test(int num_players, int num_rounds, int batch_size,
+                          int &total_count, int &correct_count) {
+    cout << "\n--- Range Add Batch Test: " << num_players << " players, "
+         << num_rounds << " rounds of " << batch_size << " queries ---" << endl;
+
+    segment_tree leaderboard(num_players);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+
+    thread_pool pool(4);
+    for (int r = 0; r < num_rounds; ++r) {
+        int low = rand() % num_players;
+        int high = r % 2 ? num_players - 1 : min(num_players - 1, low + 20);
+        int delta = rand() % 201 - 100;
+        leaderboard.add_score_range(low, high, delta);
+        model.add_score_range(low, high, delta);
+        leaderboard.sync_indexes();
+
+        vector<range_query> queries;
+        vector<player_data> expected;
+        for (int i = 0; i < batch_size; ++i) {
+            int t1 = rand() % 1000, t2 = rand() % 1000;
+            if (t1 > t2) swap(t1, t2);
+            queries.push_back(range_query(by_time, t1, t2));
+            expected.push_back(model.query_by_time(t1, t2));
+        }
+        vector<player_data> results = query_batch(pool, leaderboard, queries);
+        for (size_t i = 0; i < results.size(); ++i) {
+            check_results(results[i], expected[i], correct_count, total_count);
+        }
+    }
+}
+
+// ================= Snapshot Test =================
+// a saved board must answer like the golden model both through the mapping and after restore_into
+void snapshot_test(int num_players, int num_updates,
+                   int &total_count, int &correct_count) {
+    cout << "\n--- Snapshot Test: " << num_players << " players, "
+         << num_updates << " updates ---" << endl;
+
+    const string path = "dsa_snapshot.bin";
+    // the board is not full , the snapshot must keep the real capacity and the real reached_index
+    segment_tree leaderboard(num_players + 100);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        model.add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+    for (int i = 0; i < num_updates; ++i) {
+        player_data new_p(rand() % 1000, rand() % num_players, rand() % 1000);
+        leaderboard.update_player_data(new_p);
+        model.update_player(new_p);
+    }
+    check_bool(save_snapshot(leaderboard, path), true, correct_count, total_count);
+
+    mapped_leaderboard mapped(path);
+    check_bool(mapped.is_open(), true, correct_count, total_count);
+    check_bool(mapped.size() == num_players + 100 && mapped.last_index() == num_players - 1, true,
+               correct_count, total_count);
+
+    segment_tree restored(mapped.size());
+    mapped.restore_into(restored);
+
+    for (int i = 0; i < 200; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        player_data expected = model.query_by_id(id1, id2);
+        check_results(mapped.query_the_tree_by_id(id1, id2), expected, correct_count, total_count);
+        check_results(restored.query_the_tree_by_id(id1, id2), expected, correct_count, total_count);
+
+        int t1 = rand() % 1100, t2 = rand() % 1100;
+        if (t1 > t2) swap(t1, t2);
+        expected = model.query_by_time(t1, t2);
+        check_results(mapped.query_the_tree_by_time(t1, t2), expected, correct_count, total_count);
+        check_results(restored.query_the_tree_by_time(t1, t2), expected, correct_count, total_count);
+    }
+
+    // the restored board keeps accepting players and updates
+    player_data extra(5000, num_players, 1);
+    restored.insert_into_tree(extra);
+    model.add_player(extra);
+    check_results(restored.query_the_tree_by_id(0, num_players), model.query_by_id(0, num_players),
+                  correct_count, total_count);
+
+    // a truncated file is refused
+    {
+        ofstream broken(path.c_str(), ios::binary | ios::trunc);
+        broken << "LBSNAP";
+    }
+    mapped_leaderboard truncated(path);
+    check_bool(truncated.is_open(), false, correct_count, total_count);
+    remove(path.c_str());
+}
+
+// ================= Journal Test =================
+// every reopen of the same journal and snapshot must rebuild the board the golden model describes
+void check_against_model(journaled_leaderboard &leaderboard, golden_model &model, int num_players,
+                         int &total_count, int &correct_count) {
+    for (int i = 0; i < 50; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2), model.query_by_id(id1, id2),
+                      correct_count, total_count);
+
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2), model.query_by_time(t1, t2),
+                      correct_count, total_count);
+    }
+}
+
+void journal_test(int num_players, int num_updates,
+                  int &total_count, int &correct_count) {
+    cout << "\n--- Journal Test: " << num_players << " players, "
+         << num_updates << " updates ---" << endl;
+
+    const string log_path = "dsa_journal.log", snapshot_path = "dsa_journal.snapshot";
+    remove(log_path.c_str());
+    remove(snapshot_path.c_str());
+    golden_model model;
+
+    // first run : half the players , some updates , synced
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        for (int i = 0; i < num_players / 2; ++i) {
+            player_data p(rand() % 1000, i, rand() % 1000);
+            model.add_player(p);
+            leaderboard.insert_into_tree(p);
+        }
+        for (int i = 0; i < num_updates; ++i) {
+            player_data new_p(rand() % 1000, rand() % (num_players / 2), rand() % 1000);
+            leaderboard.update_player_data(new_p);
+            model.update_player(new_p);
+        }
+        check_bool(leaderboard.sync(), true, correct_count, total_count);
+    }
+
+    // second run : replay , compact , then the rest of the players and more updates on top of the snapshot
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        check_against_model(leaderboard, model, num_players / 2, total_count, correct_count);
+        check_bool(leaderboard.compact(), true, correct_count, total_count);
+
+        for (int i = num_players / 2; i < num_players; ++i) {
+            player_data p(rand() % 1000, i, rand() % 1000);
+            model.add_player(p);
+            leaderboard.insert_into_tree(p);
+        }
+        for (int i = 0; i < num_updates; ++i) {
+            player_data new_p(rand() % 1000, rand() % num_players, rand() % 1000);
+            leaderboard.update_player_data(new_p);
+            model.update_player(new_p);
+        }
+        check_bool(leaderboard.update_player_data(player_data(1, num_players + 5, 1)), false,
+                   correct_count, total_count);
+        leaderboard.sync();
     }
 
-    player_data query_by_id(int start_id, int end_id) {
-        player_data best;
-        for (const auto &p : players) {
-            if (p.player_id >= start_id && p.player_id <= end_id) {
-                best = player_data::best_player(best, p);
+    // third run : players leave before a compaction , the next inserts reuse their slots and are journaled by slot ,
+    // replay must put them back into the same slots
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        vector<int> free_ids;
+        for (int i = 0; i < 8; ++i) {
+            int id = rand() % num_players;
+            if (leaderboard.remove_player(id)) {
+                model.remove_player(id);
+                free_ids.push_back(id);
             }
         }
-        return best;
+        check_bool(leaderboard.compact(), true, correct_count, total_count);
+        while (!free_ids.empty()) {
+            player_data p(rand() % 1000, free_ids.back(), rand() % 1000);
+            free_ids.pop_back();
+            check_bool(leaderboard.insert_into_tree(p) == p.player_id, true, correct_count, total_count);
+            model.add_player(p);
+        }
+        leaderboard.sync();
+    }
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        check_bool(leaderboard.board().player_count() == num_players, true, correct_count, total_count);
+        check_against_model(leaderboard, model, num_players, total_count, correct_count);
     }
 
-    bool update_player(const player_data &new_data) {
-        for (auto &p : players) {
-            if (p.player_id == new_data.player_id) {
-                p = new_data;
-                return true;
+    // fourth run : range adds , removes and batches are journaled too , then a crash after a compaction renamed its
+    // snapshot in but before it cut the journal : replay must not apply the old records a second time
+    vector<char> old_records;
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        vector<int> free_ids;
+        for (int i = 0; i < 400; ++i) {
+            if (i == 200) {
+                check_bool(leaderboard.sync(), true, correct_count, total_count);
+                FILE* log = fopen(log_path.c_str(), "rb");
+                for (int c = fgetc(log); c != EOF; c = fgetc(log)) old_records.push_back((char)c);
+                fclose(log);
+                check_bool(leaderboard.compact(), true, correct_count, total_count);
+            }
+            int choice = rand() % 4;
+            if (choice == 0) {
+                int id1 = rand() % num_players, id2 = rand() % num_players;
+                if (id1 > id2) swap(id1, id2);
+                int delta = rand() % 41 - 20;
+                check_bool(leaderboard.add_score_range(id1, id2, delta), true, correct_count, total_count);
+                model.add_score_range(id1, id2, delta);
+            } else if (choice == 1) {
+                vector<player_data> batch;
+                for (int j = 0; j < 4; ++j) batch.push_back(player_data(rand() % 1000, rand() % num_players, rand() % 1000));
+                vector<bool> ok = leaderboard.apply_updates(batch);
+                for (size_t j = 0; j < batch.size(); ++j) {
+                    if (ok[j]) model.update_player(batch[j]);
+                }
+            } else if (choice == 2) {
+                int id = rand() % num_players;
+                if (leaderboard.remove_player(id)) {
+                    model.remove_player(id);
+                    free_ids.push_back(id);
+                }
+            } else if (!free_ids.empty()) {
+                player_data p(rand() % 1000, free_ids.back(), rand() % 1000);
+                free_ids.pop_back();
+                check_bool(leaderboard.insert_into_tree(p) == p.player_id, true, correct_count, total_count);
+                model.add_player(p);
             }
         }
-        return false;
+        check_bool(leaderboard.sync(), true, correct_count, total_count);
+        leaderboard.sync_indexes();
+        check_against_model(leaderboard, model, num_players, total_count, correct_count);
+    }
+    {
+        // the journal as it was before the compaction , followed by what came after
+        vector<char> new_records;
+        FILE* log = fopen(log_path.c_str(), "rb");
+        for (int c = fgetc(log); c != EOF; c = fgetc(log)) new_records.push_back((char)c);
+        fclose(log);
+        log = fopen(log_path.c_str(), "wb");
+        fwrite(old_records.data(), 1, old_records.size(), log);
+        fwrite(new_records.data(), 1, new_records.size(), log);
+        fclose(log);
+    }
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        check_against_model(leaderboard, model, num_players, total_count, correct_count);
     }
 
-private:
-    vector<player_data> players;
-};
+    // a crash in the middle of a batch leaves whole records of it behind , replay drops the batch and later
+    // appends follow the last complete write
+    {
+        journal_record torn[2] = {journal_record(journal_batch, 0, 3, 0, 1LL << 40),
+                                  journal_record(journal_update, 5, 0, 5, 1LL << 40)};
+        FILE* log = fopen(log_path.c_str(), "ab");
+        fwrite(torn, sizeof(journal_record), 2, log);
+        fclose(log);
+    }
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        check_against_model(leaderboard, model, num_players, total_count, correct_count);
+        int id = rand() % num_players;
+        while (leaderboard.query_the_tree_by_id(id, id).player_id == -1) id = rand() % num_players;
+        player_data new_p(rand() % 1000, id, rand() % 1000);
+        check_bool(leaderboard.update_player_data(new_p), true, correct_count, total_count);
+        model.update_player(new_p);
+        leaderboard.sync();
+    }
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        check_against_model(leaderboard, model, num_players, total_count, correct_count);
+    }
 
-// ================= Helper Functions =================
-void print_player(const string &label, const player_data &p) {
-    cout << setw(25) << left << label
-         << " | Score: " << setw(4) << p.score
-         << " PlayerID: " << setw(3) << p.player_id
-         << " Time: " << setw(3) << p.finish_time << endl;
+    // a crash in the middle of a record leaves a torn tail , replay must stop at the last whole record
+    {
+        FILE* log = fopen(log_path.c_str(), "ab");
+        fwrite("torn", 1, 4, log);
+        fclose(log);
+    }
+    {
+        journaled_leaderboard leaderboard(num_players, log_path, snapshot_path, 64, 1);
+        check_bool(leaderboard.board().last_index() == num_players - 1, true, correct_count, total_count);
+        check_against_model(leaderboard, model, num_players, total_count, correct_count);
+    }
+
+    remove(log_path.c_str());
+    remove(snapshot_path.c_str());
 }
 
-bool check_results(const player_data &actual,
-                   const player_data &expected,
-                   int &correctCount, int &totalCount) {
-    totalCount++;
-    bool pass = (actual.score == expected.score &&
-                 actual.player_id == expected.player_id &&
-                 actual.finish_time == expected.finish_time);
-    if (pass) {
-        correctCount++;
-        cout << "[PASS] "<< endl;
-    } else {
-        cout << "[FAIL] " << endl;
-        cout << "   Expected -> ";
-        print_player("", expected);
-        cout << "   Got      -> ";
-        print_player("", actual);
+// ================= Ingest Test =================
+// the same rows written as csv and as binary , loaded by both ingest paths , must give the board of plain inserts
+void ingest_test(int num_players, int &total_count, int &correct_count) {
+    cout << "\n--- Ingest Test: " << num_players << " players ---" << endl;
+
+    const string csv_path = "dsa_ingest.csv", binary_path = "dsa_ingest.bin";
+    segment_tree expected(num_players);
+    {
+        FILE* csv = fopen(csv_path.c_str(), "wb");
+        FILE* binary = fopen(binary_path.c_str(), "wb");
+        fputs("score,finish_time\n", csv); // header , skipped as a bad row
+        for (int i = 0; i < num_players; ++i) {
+            int row[2] = {rand() % 2000 - 1000, rand() % 1000};
+            expected.insert_into_tree(player_data(row[0], i, row[1]));
+            fprintf(csv, i % 7 == 0 ? "%d,%d\r\n" : "%d,%d\n", row[0], row[1]);
+            if (i % 100 == 0) fputs("\n12,x\n", csv); // a blank line and a broken row
+            fwrite(row, sizeof(int), 2, binary);
+        }
+        fclose(csv);
+        fclose(binary);
     }
-    return pass;
-}
 
-void check_bool(bool actual, bool expected,
-                int &correctCount, int &totalCount) {
-    totalCount++;
-    if (actual == expected) {
-        correctCount++;
-        cout << "[PASS] " << endl;
-    } else {
-        cout << "[FAIL] " << " Expected=" << expected << " Got=" << actual << endl;
+    segment_tree from_csv(num_players);
+    int fd = open(csv_path.c_str(), O_RDONLY);
+    ingest_stats csv_stats = ingest_fd(from_csv, fd, ingest_csv, 64); // tiny chunks , rows straddle every read
+    close(fd);
+
+    flat_segment_tree from_binary(num_players);
+    ingest_stats binary_stats = ingest_mapped(from_binary, binary_path, ingest_binary);
+
+    check_bool(csv_stats.rows == num_players && csv_stats.bad_rows == 1 + (num_players + 99) / 100, true,
+               correct_count, total_count);
+    check_bool(binary_stats.rows == num_players && binary_stats.bad_rows == 0, true,
+               correct_count, total_count);
+
+    for (int i = 0; i < 100; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        player_data want = expected.query_the_tree_by_id(id1, id2);
+        check_results(from_csv.query_the_tree_by_id(id1, id2), want, correct_count, total_count);
+        check_results(from_binary.query_the_tree_by_id(id1, id2), want, correct_count, total_count);
+
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        want = expected.query_the_tree_by_time(t1, t2);
+        check_results(from_csv.query_the_tree_by_time(t1, t2), want, correct_count, total_count);
+        check_results(from_binary.query_the_tree_by_time(t1, t2), want, correct_count, total_count);
     }
+    remove(csv_path.c_str());
+    remove(binary_path.c_str());
 }
 
-// ================= Stress Test =================
-void stress_test(int num_players, int num_queries,
-                 int &total_count, int &correct_count) {
-    cout << "\n--- Stress Test: " << num_players
-         << " players, " << num_queries << " queries ---" << endl;
+// ================= Sliding Window Test =================
+// the golden model keeps every player , only those at or after window_start may count
+void sliding_window_test(int window, int bucket_width, int num_steps,
+                         int &total_count, int &correct_count) {
+    cout << "\n--- Sliding Window Test: window " << window << ", bucket " << bucket_width
+         << ", " << num_steps << " steps ---" << endl;
 
-    segment_tree leaderboard(num_players);
+    sliding_window_leaderboard leaderboard(window, bucket_width);
     golden_model model;
+    int now = 0;
+    for (int step = 0; step < num_steps; ++step) {
+        // time moves a little most steps , now and then it jumps past the whole window
+        now += step % 97 == 96 ? 3 * window : rand() % 3;
 
-    // Insert players
+        // players arrive out of order , some already too old to enter
+        player_data p(rand() % 1000, -1, max(0, now - rand() % (window + window / 2)));
+        int before = leaderboard.last_index();
+        leaderboard.insert_into_tree(p);
+        if (leaderboard.last_index() != before) {
+            model.add_player(player_data(p.score, leaderboard.last_index(), p.finish_time));
+        }
+
+        // updates may move a player to another bucket or out of the window
+        if (leaderboard.last_index() >= 0) {
+            player_data new_p(rand() % 1000, rand() % (leaderboard.last_index() + 1),
+                              max(0, now - rand() % (window + window / 4)));
+            if (leaderboard.update_player_data(new_p)) model.update_player(new_p);
+        }
+
+        if (step % 10 == 0) {
+            int start = leaderboard.window_start();
+            check_results(leaderboard.best(), model.query_by_time(start, INT_MAX),
+                          correct_count, total_count);
+            check_list(leaderboard.top_k(10), model.top_k_by_time(start, INT_MAX, 10),
+                       correct_count, total_count);
+            check_bool(leaderboard.size() == (int)model.top_k_by_time(start, INT_MAX, INT_MAX).size(), true,
+                       correct_count, total_count);
+            check_bool(leaderboard.bucket_entries() == leaderboard.size(), true, correct_count, total_count);
+        }
+    }
+
+    // one player updated over and over , back and forth between two buckets , holds a single entry
+    sliding_window_leaderboard busy(window, bucket_width);
+    busy.insert_into_tree(player_data(1, -1, window));
+    for (int i = 0; i < 10000; ++i) {
+        busy.update_player_data(player_data(i, 0, window - (i % 2) * bucket_width));
+    }
+    check_bool(busy.size() == 1 && busy.bucket_entries() == 1, true, correct_count, total_count);
+}
+
+// ================= Offline Batch Test =================
+// the sweep must give exactly the online answers , including the empty player for invalid or empty ranges
+template <class Tree>
+void offline_batch_test(int num_players, int batch_size,
+                        int &total_count, int &correct_count) {
+    cout << "\n--- Offline Batch Test: " << num_players << " players, "
+         << batch_size << " queries ---" << endl;
+
+    Tree leaderboard(num_players);
     for (int i = 0; i < num_players; ++i) {
-        int score = rand() % 1000;
-        int finish_time = rand() % 1000;
-        player_data p(score, i, finish_time);
+        // narrow ranges so equal scores and equal times are common
+        leaderboard.insert_into_tree(player_data(rand() % 100, i, rand() % 300));
+    }
+    for (int i = 0; i < num_players / 2; ++i) {
+        leaderboard.update_player_data(player_data(rand() % 100, rand() % num_players, rand() % 300));
+    }
+
+    vector<range_query> queries;
+    for (int i = 0; i < batch_size; ++i) {
+        int low = rand() % (num_players + 20) - 10, high = rand() % (num_players + 20) - 10;
+        if (rand() % 10) {
+            if (low > high) swap(low, high);
+        }
+        if (rand() % 2) queries.push_back(range_query(by_id, low, high));
+        else queries.push_back(range_query(by_time, low % 320, high % 320));
+    }
+
+    vector<player_data> offline = offline_query_batch(leaderboard, queries);
+    check_bool(offline.size() == queries.size(), true, correct_count, total_count);
+    for (size_t i = 0; i < queries.size() && i < offline.size(); ++i) {
+        const range_query &q = queries[i];
+        player_data online = q.kind == by_id ? leaderboard.query_the_tree_by_id(q.low, q.high)
+                                             : leaderboard.query_the_tree_by_time(q.low, q.high);
+        check_results(offline[i], online, correct_count, total_count);
+    }
+}
+
+// ================= Sharded Test =================
+// writers update disjoint players from several threads , the merged answers must match one golden model
+void sharded_test(int num_players, int num_shards, int num_writers, int updates_per_writer,
+                  int &total_count, int &correct_count) {
+    cout << "\n--- Sharded Test: " << num_players << " players, "
+         << num_shards << " shards, " << num_writers << " writers ---" << endl;
+
+    sharded_leaderboard leaderboard(num_players, num_shards);
+    golden_model model;
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
         model.add_player(p);
         leaderboard.insert_into_tree(p);
     }
 
-    // Query by time
-    for (int i = 0; i < num_queries; ++i) {
+    // writer w owns the players with id % num_writers == w , so the final state does not depend on timing
+    vector<vector<player_data> > updates(num_writers);
+    for (int w = 0; w < num_writers; ++w) {
+        for (int i = 0; i < updates_per_writer; ++i) {
+            int id = (rand() % num_players) / num_writers * num_writers + w;
+            if (id >= num_players) id = w;
+            updates[w].push_back(player_data(rand() % 1000, id, rand() % 1000));
+        }
+    }
+
+    vector<thread> writers;
+    for (int w = 0; w < num_writers; ++w) {
+        writers.push_back(thread([&, w]() {
+            for (size_t i = 0; i < updates[w].size(); ++i) leaderboard.update_player_data(updates[w][i]);
+        }));
+    }
+    for (int w = 0; w < num_writers; ++w) writers[w].join();
+    for (int w = 0; w < num_writers; ++w) {
+        for (size_t i = 0; i < updates[w].size(); ++i) model.update_player(updates[w][i]);
+    }
+
+    check_results(leaderboard.global_best(), model.query_by_id(0, num_players - 1),
+                  correct_count, total_count);
+    for (int i = 0; i < 100; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2),
+                      model.query_by_id(id1, id2),
+                      correct_count, total_count);
+
         int t1 = rand() % 1000, t2 = rand() % 1000;
-        //invalid ranges in the main
         if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2),
+                      model.query_by_time(t1, t2),
+                      correct_count, total_count);
+    }
+}
 
-        player_data actual = leaderboard.query_the_tree_by_time(t1, t2);
-        player_data expected = model.query_by_time(t1, t2);
-        check_results(actual, expected, correct_count, total_count);
+// ================= Versioned Test =================
+// a golden model is kept for every version , any old version must still answer like it did back then
+void versioned_test(int num_players, int num_updates,
+                    int &total_count, int &correct_count) {
+    cout << "\n--- Versioned Test: " << num_players << " players, "
+         << num_updates << " updates ---" << endl;
+
+    versioned_leaderboard leaderboard(num_players);
+    vector<golden_model> history(1);
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        history.push_back(history.back());
+        history.back().add_player(p);
+        leaderboard.insert_into_tree(p);
+    }
+    for (int i = 0; i < num_updates; ++i) {
+        player_data p(rand() % 1000, rand() % num_players, rand() % 1000);
+        history.push_back(history.back());
+        history.back().update_player(p);
+        leaderboard.update_player_data(p);
     }
+    check_bool(leaderboard.current_version() == (int)history.size() - 1, true,
+               correct_count, total_count);
 
-    // Query by ID
-    for (int i = 0; i < num_queries; ++i) {
+    for (int i = 0; i < 300; ++i) {
+        int version = num_players + rand() % (num_updates + 1);
         int id1 = rand() % num_players, id2 = rand() % num_players;
-        //invalid ranges in the main
         if (id1 > id2) swap(id1, id2);
+        check_results(leaderboard.query_the_tree_by_id(id1, id2, version),
+                      history[version].query_by_id(id1, id2),
+                      correct_count, total_count);
 
-        player_data actual = leaderboard.query_the_tree_by_id(id1, id2);
-        player_data expected = model.query_by_id(id1, id2);
-        check_results(actual, expected, correct_count, total_count);
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        check_results(leaderboard.query_the_tree_by_time(t1, t2, version),
+                      history[version].query_by_time(t1, t2),
+                      correct_count, total_count);
     }
 
-    // Random updates
-    for (int i = 0; i < num_queries; ++i) {
-        int id = rand() % num_players;
-        player_data new_p(rand() % 1000, id, rand() % 1000);
-        bool act = leaderboard.update_player_data(new_p);
-        bool exp = model.update_player(new_p);
-        check_bool(act, exp,
-                   correct_count, total_count);
+    // while the board was filling up , ids above reached_index did not exist yet
+    check_results(leaderboard.query_the_tree_by_id(0, 5, 3), player_data(),
+                  correct_count, total_count);
+    check_results(leaderboard.query_the_tree_by_id(0, 2, 3), history[3].query_by_id(0, 2),
+                  correct_count, total_count);
+}
+
+// ================= Stats Test =================
+// only built with -DLEADERBOARD_STATS
+#ifdef LEADERBOARD_STATS
+void stats_test(int num_players, int &total_count, int &correct_count) {
+    cout << "\n--- Stats Test: " << num_players << " players ---" << endl;
+
+    segment_tree leaderboard(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        leaderboard.insert_into_tree(player_data(rand() % 1000, i, rand() % 1000));
+    }
+    for (int i = 0; i < 50; ++i) {
+        leaderboard.query_the_tree_by_id(0, num_players - 1);
+        leaderboard.query_the_tree_by_time(0, 500);
+    }
+    leaderboard.update_player_data(player_data(5, 3, 5));
+
+    tree_stats snap = leaderboard.stats_snapshot();
+    const op_stats &ins = snap.ops[op_insert];
+    const op_stats &by_id = snap.ops[op_query_by_id];
+    const op_stats &upd = snap.ops[op_update];
+
+    check_bool(ins.calls == num_players, true, correct_count, total_count);
+    // the root and the first path are allocated once , later inserts reuse most of the path
+    check_bool(ins.nodes_allocated >= num_players && ins.nodes_allocated < 4 * num_players, true,
+               correct_count, total_count);
+    check_bool(by_id.calls == 50 && by_id.nodes_visited == 50 && by_id.nodes_allocated == 0, true,
+               correct_count, total_count);
+    check_bool(snap.ops[op_query_by_time].calls == 50 && snap.ops[op_query_by_time].comparisons > 0, true,
+               correct_count, total_count);
+    check_bool(upd.calls == 1 && upd.nodes_visited > 0 && upd.comparisons > 0, true,
+               correct_count, total_count);
+
+    long long histogram_total = 0;
+    for (int b = 0; b < latency_bucket_count; ++b) histogram_total += ins.latency_buckets[b];
+    check_bool(histogram_total == num_players, true, correct_count, total_count);
+
+    leaderboard.reset_stats();
+    check_bool(leaderboard.stats_snapshot().ops[op_insert].calls == 0, true, correct_count, total_count);
+
+    // the batch path counts from the pool threads : the same queries run one by one must give the same counters
+    vector<range_query> queries;
+    for (int i = 0; i < 640; ++i) {
+        int low = rand() % num_players, high = rand() % num_players;
+        if (low > high) swap(low, high);
+        if (i % 2) queries.push_back(range_query(range_kind::by_id, low, high));
+        else queries.push_back(range_query(range_kind::by_time, low % 1000, max(low, high) % 1000));
+    }
+    vector<player_data> serial;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        serial.push_back(queries[i].kind == range_kind::by_id ? leaderboard.query_the_tree_by_id(queries[i].low, queries[i].high)
+                                                  : leaderboard.query_the_tree_by_time(queries[i].low, queries[i].high));
+    }
+    tree_stats serial_snap = leaderboard.stats_snapshot();
+    leaderboard.reset_stats();
+
+    thread_pool pool(4);
+    vector<player_data> results = query_batch(pool, leaderboard, queries);
+    tree_stats batch_snap = leaderboard.stats_snapshot();
+    for (size_t i = 0; i < results.size(); ++i) check_results(results[i], serial[i], correct_count, total_count);
+    for (int op = op_query_by_id; op <= op_query_by_time; ++op) {
+        const op_stats &a = serial_snap.ops[op], &b = batch_snap.ops[op];
+        long long buckets = 0;
+        for (int k = 0; k < latency_bucket_count; ++k) buckets += b.latency_buckets[k];
+        check_bool(a.calls == 320 && b.calls == a.calls && b.nodes_visited == a.nodes_visited &&
+                   b.comparisons == a.comparisons && buckets == b.calls, true, correct_count, total_count);
     }
 }
+#endif
 
 // ================= Main =================
 int main() {
@@ -204,10 +1869,51 @@ int main() {
           check_results(p3, player_data(-1, -1, -1), correctCount, totalCount);
 
      }
+    ranking_order_test(2000, totalCount, correctCount);
+
     // Stress tests
-    stress_test(500, 100, totalCount, correctCount);
-    stress_test(1000, 200, totalCount, correctCount);
-    stress_test(5000, 500, totalCount, correctCount);
+    stress_test<segment_tree>(500, 100, totalCount, correctCount);
+    stress_test<segment_tree>(1000, 200, totalCount, correctCount);
+    stress_test<segment_tree>(5000, 500, totalCount, correctCount);
+    stress_test<flat_segment_tree>(1000, 200, totalCount, correctCount);
+    stress_test<flat_segment_tree>(5000, 500, totalCount, correctCount);
+    time_index_test(2000, 500, totalCount, correctCount);
+    bulk_load_test<segment_tree>(3000, 300, totalCount, correctCount);
+    bulk_load_test<flat_segment_tree>(3000, 300, totalCount, correctCount);
+    batch_update_test<segment_tree>(2000, 300, totalCount, correctCount);
+    batch_update_test<flat_segment_tree>(2000, 300, totalCount, correctCount);
+    top_k_test<segment_tree>(1500, 200, totalCount, correctCount);
+    top_k_test<flat_segment_tree>(1500, 200, totalCount, correctCount);
+    rank_test<segment_tree>(1000, 200, totalCount, correctCount);
+    rank_test<flat_segment_tree>(1000, 200, totalCount, correctCount);
+    id_time_test<segment_tree>(2000, 400, totalCount, correctCount);
+    freeze_test(1000, 100, totalCount, correctCount);
+    range_add_test(2000, 600, totalCount, correctCount);
+    negative_score_test(300, 400, totalCount, correctCount);
+    growth_test(3000, 300, totalCount, correctCount);
+    remove_test(1500, 1500, totalCount, correctCount);
+    external_id_test(2000, 3000, totalCount, correctCount);
+    multi_aggregate_test(2000, 1200, totalCount, correctCount);
+    id_time_test<flat_segment_tree>(2000, 400, totalCount, correctCount);
+    concurrent_test(2000, 20000, 3, totalCount, correctCount);
+    versioned_test(200, 400, totalCount, correctCount);
+    sharded_test(3001, 4, 4, 2000, totalCount, correctCount);
+    sharded_test(10, 16, 2, 100, totalCount, correctCount);
+    query_batch_test<segment_tree>(2000, 5, 300, totalCount, correctCount);
+    query_batch_test<flat_segment_tree>(2000, 5, 300, totalCount, correctCount);
+    range_add_batch_test(2000, 6, 400, totalCount, correctCount);
+    query_batch_test<concurrent_leaderboard>(1000, 3, 300, totalCount, correctCount);
+    offline_batch_test<segment_tree>(3000, 2000, totalCount, correctCount);
+    offline_batch_test<flat_segment_tree>(3000, 2000, totalCount, correctCount);
+    snapshot_test(3000, 500, totalCount, correctCount);
+    journal_test(2000, 3000, totalCount, correctCount);
+    ingest_test(5000, totalCount, correctCount);
+    sliding_window_test(100, 10, 2000, totalCount, correctCount);
+    sliding_window_test(50, 1, 2000, totalCount, correctCount);
+    sliding_window_test(64, 7, 2000, totalCount, correctCount);
+#ifdef LEADERBOARD_STATS
+    stats_test(1000, totalCount, correctCount);
+#endif
 
     // Final report
     cout << "\n=== Final Report ===" << endl;
@@ -1,4 +1,6 @@
 #pragma once 
+#include <vector>
+
 /**
  *  @brief Represents player data in the leaderboard.
 */
@@ -23,47 +25,918 @@ public:
 
     /**
     * @brief Compares two player_data parameters to determine the better player.
+    *
+    * Higher score wins, then the earlier finish_time, then the larger player_id.
     * @param a The first player_data parameters.
     * @param b The second player_data parameters.
     * @return The player_data parameters representing the better player.
     */
     static player_data best_player(const player_data &a, const player_data &b);
+
+    /**
+    * @brief Strict form of the best_player ordering, usable as a sort comparator.
+    * @param a The first player_data parameters.
+    * @param b The second player_data parameters.
+    * @return True if a ranks above b. An empty slot (player_id -1) ranks below every player.
+    */
+    static bool ranks_higher(const player_data &a, const player_data &b);
+};
+
+/**
+ *  @brief A player packed into one 128-bit key that orders like ranks_higher.
+ *
+ *  The biased score fills the top 64 bits, the inverted finish_time sits below
+ *  it and the biased player_id is the tie break. The empty player is 0. The key
+ *  holds all three fields, so flat_segment_tree stores keys only and combines
+ *  two nodes with one unsigned max. A GCC / Clang extension.
+ */
+typedef unsigned __int128 ranking_key;
+
+/**
+ * @brief Packs a player into its ranking_key.
+ * @return pack_player(a) > pack_player(b) exactly when ranks_higher(a, b).
+ */
+ranking_key pack_player(const player_data &p);
+
+/**
+ * @brief The player a ranking_key was packed from, the empty player for 0.
+ */
+player_data unpack_player(ranking_key key);
+
+/**
+*  @brief Combine policy keeping no aggregates; its value is empty and costs no node memory.
+*
+*  A combine policy gives the value type kept in every node next to the best
+*  player (default constructed is the empty range), the value of one player
+*  (the empty player counts as nothing), how two values combine (associative and
+*  commutative) and what adding delta to every player's score does to a value.
+*/
+struct no_aggregates{
+    struct value{};
+    static value of(const player_data &p);
+    static value combine(const value &a, const value &b);
+    static void shift(value &v, int delta);
+};
+
+/**
+*  @brief Combine policy: number of players and their total score.
+*/
+struct score_sum_aggregate{
+    struct value{
+        int count;              ///< Number of players
+        long long total;        ///< Sum of their scores
+
+        /**
+         * @brief Mean score, 0 for no players.
+         */
+        double mean() const;
+    };
+    static value of(const player_data &p);
+    static value combine(const value &a, const value &b);
+    static void shift(value &v, int delta);
+};
+
+/**
+*  @brief Combine policy: earliest finish_time, INT_MAX for no players.
+*/
+struct earliest_finish_aggregate{
+    struct value{
+        int earliest;           ///< Earliest finish_time
+    };
+    static value of(const player_data &p);
+    static value combine(const value &a, const value &b);
+    static void shift(value &v, int delta);
 };
 
 /**
-*  @brief Represents a node in the segment tree.
+*  @brief Two combine policies side by side; the members of both values are reachable directly.
 */
-class tree_node{
+template <class First, class Second>
+struct both_aggregates{
+    struct value : First::value, Second::value{};
+    static value of(const player_data &p);
+    static value combine(const value &a, const value &b);
+    static void shift(value &v, int delta);
+};
+
+/**
+*  @brief Count, total and mean score, and earliest finish of a range.
+*/
+typedef both_aggregates<score_sum_aggregate,earliest_finish_aggregate> dashboard_aggregates;
+
+/**
+*  @brief Answer of a multi-aggregate range query: the best player plus every value of the policy.
+*  @tparam Agg The combine policy.
+*/
+template <class Agg>
+struct range_summary : Agg::value{
+    player_data best;           ///< Best player of the range
+
+    /**
+     * @brief Summary of two disjoint ranges.
+     */
+    static range_summary join(const range_summary &a, const range_summary &b);
+};
+
+/**
+*  @brief Represents a node in the segment tree, carrying the aggregates of Agg over its segment.
+*  @tparam Agg The combine policy.
+*/
+template <class Agg>
+class basic_tree_node : public Agg::value{
     public:
         player_data p;          ///< Player data
         int l, r;               ///< Left and right bounds
-        tree_node* left_ptr;    ///< Pointer to left child
-        tree_node* right_ptr;   ///< Pointer to right child
+        int pending;            ///< Score added to the subtree, already in p, not yet in the children
+        basic_tree_node* left_ptr;    ///< Pointer to left child
+        basic_tree_node* right_ptr;   ///< Pointer to right child
+
+        /**
+         * @brief Constructor for tree_node with bounds.
+         * @param L The left bound.
+         * @param R The right bound.
+         */
+        basic_tree_node(int L, int R);
+
+        /**
+         * @brief Constructor for tree_node with bounds and player data.
+         * @param L The left bound.
+         * @param R The right bound.
+         * @param score Player's score.
+         * @param player_id Player's ID.
+         * @param finish_time Player's finish time.
+         */
+        basic_tree_node(int L, int R, int score, int player_id, int finish_time);
+
+};
+
+typedef basic_tree_node<no_aggregates> tree_node;
+
+/**
+*  @brief Allocates tree and index nodes from blocks and releases them all at once.
+*         Blocks start at 16 nodes and double up to 1024.
+*  @tparam Node The node type, trivially destructible and chained through left_ptr when released.
+*/
+template <class Node>
+class basic_node_pool{
+    private:
+        std::vector<Node*> blocks; ///< Raw storage blocks
+        Node* next_free;        ///< Next unused node of the current block
+        int left_in_block;      ///< Unused nodes left in the current block
+        int block_size;         ///< Size of the next block create adds
+        Node* released;         ///< Nodes given back with release, chained through left_ptr
+
+        /**
+         * @brief Allocates a new block and makes it the current one.
+         * @param count The number of nodes in the block.
+         */
+        void add_block(int count);
+
+    public:
+        /**
+         * @brief Constructor for an empty node_pool.
+         */
+        basic_node_pool();
+
+        /**
+         * @brief Destructor, releases every block.
+         */
+        ~basic_node_pool();
+
+        /**
+         * @brief Frees every node at once; the pool starts over empty.
+         */
+        void clear();
+
+        /**
+         * @brief Makes sure the next count nodes come from a single allocation.
+         * @param count The number of nodes needed.
+         */
+        void reserve(int count);
+
+        /**
+         * @brief Creates a node from the given constructor arguments, reusing a released node if there is one.
+         * @param args The arguments of the Node constructor.
+         * @return Pointer to the new node.
+         */
+        template <class... Args>
+        Node* create(Args... args);
+
+        /**
+         * @brief Takes a node back; the next create hands it out again.
+         * @param node The node, no longer reachable from any tree.
+         */
+        void release(Node* node);
+};
+
+typedef basic_node_pool<tree_node> node_pool;
+
+/**
+*  @brief Represents a node of the treap behind the secondary indexes, carrying the aggregates of Agg over its subtree.
+*  @tparam Agg The combine policy.
+*/
+template <class Agg>
+class basic_index_node : public Agg::value{
+    public:
+        player_data p;          ///< Player data
+        player_data best;       ///< Best player of the subtree
+        int size;               ///< Number of players in the subtree
+        unsigned priority;      ///< Heap priority of the treap
+        basic_index_node* left_ptr;   ///< Pointer to left child
+        basic_index_node* right_ptr;  ///< Pointer to right child
+
+        /**
+         * @brief Constructor for index_node.
+         * @param data The player_data stored in the node.
+         * @param prio The heap priority of the node.
+         */
+        basic_index_node(player_data data, unsigned prio);
+};
+
+typedef basic_index_node<no_aggregates> index_node;
+
+/**
+*  @brief Key of the finish_time index: finish_time, then player_id.
+*/
+struct finish_time_order{
+    bool operator()(const player_data &a, const player_data &b) const;
+};
+
+/**
+*  @brief Key of the rank index: the best_player ordering, best first, empty slots last.
+*/
+struct rank_order{
+    bool operator()(const player_data &a, const player_data &b) const;
+};
+
+/**
+*  @brief Players kept sorted by Order in a treap, with subtree best, size and aggregates in every node.
+*  @tparam Order Strict weak ordering of player_data.
+*  @tparam Agg The combine policy.
+*/
+template <class Order, class Agg = no_aggregates>
+class ordered_index{
+    protected:
+        typedef basic_index_node<Agg> index_node; ///< Node type of this index
+        index_node* root_node;  ///< Pointer to the root of the treap
+        unsigned seed;          ///< State of the priority generator
+        basic_node_pool<index_node> pool; ///< Owns every node of this index, not the copies of the static helpers
+
+    public:
+        /**
+         * @brief Constructor for an empty ordered_index.
+         */
+        ordered_index();
+
+        /**
+         * @brief Destructor, releases every node.
+         */
+        ~ordered_index();
+
+        /**
+         * @brief Number of players in the index.
+         */
+        int size();
+
+        /**
+         * @brief Adds a player to the index in O(log n).
+         * @param p The player_data to add.
+         */
+        void insert(player_data p);
+
+        /**
+         * @brief Removes a player from the index in O(log n).
+         * @param p The player_data to remove, matched by its key.
+         * @return True if the player was found, false otherwise.
+         */
+        bool erase(player_data p);
+
+        /**
+         * @brief Drops every player.
+         */
+        void clear();
+
+        /**
+         * @brief Moves a player to its new key in O(log n), reusing its node.
+         * @param old_data The player's current data.
+         * @param new_data The player's new data.
+         */
+        void replace(player_data old_data, player_data new_data);
+
+        /**
+         * @brief Builds the index from a roster: one sort, then a linear treap build.
+         * @param players The players to index; united with the existing treap if the index is not empty.
+         */
+        void build_from(std::vector<player_data> players);
+
+        /**
+         * @brief Path copying insert: the tree below node is left untouched.
+         * @param node The root of the version to insert into.
+         * @param fresh The new node to insert.
+         * @param replaced Receives every node of the old version that the new one no longer uses.
+         * @param created If given, receives every node allocated by the call.
+         * @return The root of the new version.
+         */
+        static index_node* insert_copy(index_node* node, index_node* fresh, std::vector<index_node*> &replaced, std::vector<index_node*>* created = 0);
+
+        /**
+         * @brief Path copying merge of two trees whose keys are all ordered l before r.
+         * @param l The left tree.
+         * @param r The right tree.
+         * @param replaced Receives every node of the old trees that the merged one no longer uses.
+         * @param created If given, receives every node allocated by the call.
+         * @return The root of the merged tree.
+         */
+        static index_node* merge_copy(index_node* l, index_node* r, std::vector<index_node*> &replaced, std::vector<index_node*>* created = 0);
+
+        /**
+         * @brief Path copying erase: the tree below node is left untouched.
+         * @param node The root of the version to erase from.
+         * @param key The player_data to remove, matched by its key.
+         * @param replaced Receives every node of the old version that the new one no longer uses.
+         * @param created If given, receives every node allocated by the call.
+         * @return The root of the new version.
+         */
+        static index_node* erase_copy(index_node* node, const player_data &key, std::vector<index_node*> &replaced, std::vector<index_node*>* created = 0);
+
+        /**
+         * @brief Counts the players whose key is smaller than key in O(log n).
+         * @param key The key to compare with.
+         */
+        int count_less(const player_data &key) const;
+
+        /**
+         * @brief Returns the player at a 0-based position of the order in O(log n).
+         * @param i The position.
+         * @return The player, or the empty player if i is out of range.
+         */
+        player_data select(int i) const;
+};
+
+/**
+*  @brief Secondary index of the players keyed by finish_time.
+*
+*  Players are kept sorted by (finish_time, player_id), so a player's position
+*  acts as its compressed time coordinate even while updates move players around.
+*  @tparam Agg The combine policy.
+*/
+template <class Agg>
+class basic_time_index : public ordered_index<finish_time_order,Agg>{
+    public:
+        /**
+         * @brief Returns the k best players within a time range, best first, in about O(k log n).
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @param k The number of players wanted.
+         * @return Up to k players ordered by best_player.
+         */
+        std::vector<player_data> top_k(int start_time, int finish_time, int k) const;
+
+        /**
+         * @brief Queries the index for the best player within a time range in O(log n).
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @return The player_data representing the best player within the time range.
+         */
+        player_data query(int start_time, int finish_time) const;
+
+        /**
+         * @brief Same query on any version of the index.
+         * @param node The root of the version.
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @return The player_data representing the best player within the time range.
+         */
+        static player_data query_root(index_node* node, int start_time, int finish_time);
+
+        /**
+         * @brief query with every aggregate of Agg over the same players, still one O(log n) walk.
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @return The best player and the aggregates of the time range.
+         */
+        range_summary<Agg> summary(int start_time, int finish_time) const;
+};
+
+typedef basic_time_index<no_aggregates> time_index;
+
+/**
+*  @brief Order-statistic index of the players under the best_player ordering.
+*/
+class rank_index : public ordered_index<rank_order>{
+    public:
+        /**
+         * @brief Global rank of a player in O(log n).
+         * @param p The player's current data.
+         * @return The 1-based rank, 1 being the best player.
+         */
+        int rank_of(const player_data &p) const;
+
+        /**
+         * @brief The player holding a global rank in O(log n).
+         * @param rank The 1-based rank.
+         * @return The player, or the empty player if there is none.
+         */
+        player_data player_at(int rank) const;
+};
+
+/**
+*  @brief Two dimensional index for combined ID range and finish_time window queries.
+*
+*  A segment tree over blocks of 32 player IDs; every node keeps a time_index of
+*  the players below it. Partial end blocks are scanned directly. Queries and
+*  updates are O(log^2 n), memory is O(n log(n / 32)) index nodes.
+*/
+class id_time_index{
+    public:
+        /**
+         * @brief Creates an empty index.
+         * @param size The maximum number of players.
+         */
+        id_time_index(int size);
+
+        /**
+         * @brief Adds a new player under its ID.
+         * @param p The player_data to add.
+         */
+        void add(const player_data &p);
+
+        /**
+         * @brief Moves a player to its new data in every node above it.
+         * @param old_data The player's current data.
+         * @param new_data The player's new data.
+         */
+        void replace(const player_data &old_data, const player_data &new_data);
+
+        /**
+         * @brief Takes a player out of every node above it.
+         * @param p The player's current data.
+         */
+        void remove(const player_data &p);
+
+        /**
+         * @brief Adds players, every node above them built in one pass.
+         * @param batch Players in ID order, gaps allowed.
+         */
+        void build_from(const std::vector<player_data> &batch);
+
+        /**
+         * @brief Number of IDs the index can hold.
+         */
+        int capacity() const;
+
+        /**
+         * @brief Doubles the ID range; the old heap becomes the left half, only the new root is built.
+         */
+        void grow();
+
+        /**
+         * @brief Best player with an ID in [begin_id, end_id] and a finish_time in [start_time, finish_time].
+         * @return The best player, or the empty player if none matches.
+         */
+        player_data query(int begin_id, int end_id, int start_time, int finish_time);
+};
+
+/**
+*  @brief Every index kept next to a tree, updated together with its leaves.
+*  @tparam Agg The combine policy of the finish_time index.
+*/
+template <class Agg>
+class basic_secondary_indexes{
+    public:
+        basic_time_index<Agg> times; ///< Index keyed by finish_time
+        rank_index ranks;       ///< Index keyed by the best_player ordering
+        id_time_index* id_times; ///< ID x finish_time index, 0 until enable_id_times
+
+        /**
+         * @brief Adds a new player to every index.
+         * @param p The player_data to add.
+         */
+        void add(const player_data &p);
+
+        /**
+         * @brief Moves a player to its new data in every index.
+         * @param old_data The player's current data.
+         * @param new_data The player's new data.
+         */
+        void replace(const player_data &old_data, const player_data &new_data);
+
+        /**
+         * @brief Takes a player out of every index.
+         * @param p The player's current data.
+         */
+        void remove(const player_data &p);
+
+        /**
+         * @brief Builds every index from a roster.
+         * @param players The players to index, in ID order; removed slots (the empty player) are skipped.
+         */
+        void build_from(const std::vector<player_data> &players);
+
+        /**
+         * @brief The players of a roster without its removed slots.
+         */
+        static std::vector<player_data> present_only(const std::vector<player_data> &players);
+
+        /**
+         * @brief Drops every index and rebuilds it from a roster; the ID x finish_time index stays enabled if it was.
+         * @param size The maximum number of players.
+         * @param players Every player, in ID order.
+         */
+        void reset(int size, const std::vector<player_data> &players);
+
+        /**
+         * @brief Grows the ID x finish_time index, if enabled, to hold IDs up to size - 1.
+         * @param size The new maximum number of players.
+         */
+        void grow(int size);
+
+        /**
+         * @brief Builds the ID x finish_time index; from then on it is maintained with the others.
+         * @param size The maximum number of players.
+         * @param players Every player so far, in ID order.
+         */
+        void enable_id_times(int size, const std::vector<player_data> &players);
+};
+
+typedef basic_secondary_indexes<no_aggregates> secondary_indexes;
+
+/**
+*  @brief One version of the leaderboard, never modified once published.
+*/
+struct leaderboard_version{
+    tree_node* id_root;         ///< Root of the ID tree
+    index_node* time_root;      ///< Root of the finish_time index
+    int reached_index;          ///< Index of the last reached player
+};
+
+/**
+*  @brief Path copying operations on the ID tree.
+*
+*  Nodes reachable from a published root are never modified: an update copies
+*  the nodes from the root to the leaf and reports the originals.
+*/
+class path_copy_tree{
+    public:
+        /**
+         * @brief Writes a leaf into a new version of the tree.
+         * @param node The root of the old version.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param index The index of the leaf.
+         * @param data The player_data to store.
+         * @param replaced Receives every node of the old version that the new one no longer uses.
+         * @return The root of the new version.
+         */
+        static tree_node* set_leaf(tree_node* node, int left, int right, int index, player_data data, std::vector<tree_node*> &replaced);
+
+        /**
+         * @brief Queries any version of the tree by player ID range.
+         * @param node The root of the version.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param start_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @return The player_data representing the best player within the ID range.
+         */
+        static player_data query(const tree_node* node, int left, int right, int start_id, int end_id);
+};
+
+/**
+ * @brief Validates a batch of updates and keeps only the last write per player_id.
+ * @param updates The batch of updates.
+ * @param reached_index The index of the last reached player.
+ * @param success Filled with true for every accepted update, false for invalid IDs.
+ * @return The surviving updates sorted by player_id.
+ */
+std::vector<player_data> coalesce_updates(const std::vector<player_data> &updates, int reached_index, std::vector<bool> &success);
+
+/**
+*  @brief Immutable O(1) range best over players in ID order.
+*
+*  Level k stores, for every start, the position of the best of the 2^k players
+*  from there; two overlapping blocks cover any range.
+*/
+class sparse_table{
+    public:
+        /**
+         * @brief Builds the table in O(n log n).
+         * @param by_id The players in ID order.
+         */
+        sparse_table(const std::vector<player_data> &by_id);
+
+        /**
+         * @brief Position of the best player of [begin, end], O(1).
+         */
+        int best_index(int begin, int end) const;
+
+        /**
+         * @brief Best player of [begin, end], O(1).
+         */
+        player_data query(int begin, int end) const;
+
+        /**
+         * @brief The players in ID order.
+         */
+        const std::vector<player_data>& by_id() const;
+
+        /**
+         * @brief Bytes held by the table, the players included.
+         */
+        size_t memory_bytes() const;
+};
+
+/**
+*  @brief Open addressing map from external 64-bit account IDs to tree slots.
+*
+*  One flat array of (key, slot) entries with linear probing, so a lookup
+*  usually touches a single cache line. Erased entries become tombstones; the
+*  table is rebuilt once live entries plus tombstones pass half of it.
+*/
+class external_id_map{
+    private:
+        /**
+         * @brief One table entry.
+         */
+        struct entry {
+            long long key;  ///< External ID
+            int slot;       ///< Tree slot, -1 for an empty entry, -2 for a tombstone
+        };
+
+        std::vector<entry> table; ///< Power of two sized table
+        size_t mask;              ///< Table size - 1
+        size_t live;              ///< Mapped keys
+        size_t used;              ///< Mapped keys plus tombstones
+
+        /**
+         * @brief splitmix64 finalizer of a key.
+         */
+        static size_t hash_of(long long key);
+
+        /**
+         * @brief Entry of a key, or the first free entry of its probe sequence.
+         */
+        size_t probe(long long key) const;
+
+        /**
+         * @brief Rebuilds the table at a given size, dropping the tombstones.
+         */
+        void rehash(size_t size);
+
+    public:
+        /**
+         * @brief Constructor for an empty map.
+         */
+        external_id_map();
+
+        /**
+         * @brief Tree slot of a key.
+         * @return The slot, or -1 if the key is not mapped.
+         */
+        int find(long long key) const;
+
+        /**
+         * @brief Maps a key to a slot.
+         * @return False if the key is already mapped.
+         */
+        bool insert(long long key, int slot);
+
+        /**
+         * @brief Unmaps a key.
+         * @return False if the key was not mapped.
+         */
+        bool erase(long long key);
+
+        /**
+         * @brief Number of mapped keys.
+         */
+        size_t size() const;
+
+        /**
+         * @brief Bytes held by the table.
+         */
+        size_t memory_bytes() const;
+};
+
+/**
+*  @brief Players that have an external ID, sorted by it in a treap.
+*
+*  Every node keeps the best player of its subtree, so the best player of an
+*  external ID range is one O(log n) walk, as in the finish_time index.
+*/
+class external_order_index{
+    private:
+        /**
+         * @brief One treap node.
+         */
+        struct node {
+            long long key;      ///< External ID
+            player_data p;      ///< The player of that account
+            player_data best;   ///< Best player of the subtree
+            unsigned priority;  ///< Heap priority
+            node* left_ptr;     ///< Smaller keys
+            node* right_ptr;    ///< Larger keys
+        };
+
+        node* root_node; ///< Root of the treap
+        unsigned seed;   ///< xorshift state for the priorities
+
+        /**
+         * @brief Splits off the keys smaller than key into l, the rest into r.
+         */
+        static void split(node* n, long long key, node* &l, node* &r);
+
+        /**
+         * @brief Rewrites the player of key and the best players on its path.
+         * @return False if key is not in the index.
+         */
+        static bool assign(node* n, long long key, const player_data &p);
+
+    public:
+        /**
+         * @brief Adds a player under an external ID that is not in the index yet, O(log n).
+         */
+        void insert(long long key, const player_data &p);
 
         /**
-         * @brief Constructor for tree_node with bounds.
-         * @param L The left bound.
-         * @param R The right bound.
+         * @brief Drops the player of an external ID, O(log n).
+         * @return False if the key was not in the index.
          */
-        tree_node(int L, int R);
+        bool erase(long long key);
 
         /**
-         * @brief Constructor for tree_node with bounds and player data.
-         * @param L The left bound.
-         * @param R The right bound.
-         * @param score Player's score.
-         * @param player_id Player's ID.
-         * @param finish_time Player's finish time.
+         * @brief Replaces the player of an external ID after a write, O(log n).
+         * @return False if the key is not in the index.
          */
-        tree_node(int L, int R, int score, int player_id, int finish_time);
+        bool assign(long long key, const player_data &p);
 
+        /**
+         * @brief Best player whose external ID is in [begin, end], O(log n).
+         */
+        player_data query(long long begin, long long end) const;
 };
 
-class segment_tree{
+/**
+*  @brief The leaderboard: a segment tree over player IDs.
+*
+*  Every node keeps the best player of its segment and the aggregates of the
+*  compile time policy Agg. segment_tree keeps no aggregates.
+*  @tparam Agg The combine policy.
+*/
+template <class Agg>
+class basic_segment_tree{
     private:
+        typedef basic_tree_node<Agg> tree_node; ///< Node type of this tree
         tree_node *root_node;   ///< Pointer to the root node of the segment tree
         int max_num_of_players; ///< Maximum number of players
         int reached_index;      ///< Index of the last reached player
+        basic_secondary_indexes<Agg> indexes; ///< finish_time and rank indexes
+        basic_node_pool<tree_node> pool; ///< Owns every tree_node of this tree
+#ifdef LEADERBOARD_STATS
+        mutable shared_tree_stats stats; ///< Hot path counters, only with -DLEADERBOARD_STATS, safe from several threads, counted by const reads too
+#endif
+        /**
+         * @brief A range add the secondary indexes have not seen yet.
+         */
+        struct score_shift {
+            int begin_id; ///< First ID of the range
+            int end_id;   ///< Last ID of the range
+            int delta;    ///< Score that was added
+        };
+        std::vector<score_shift> pending_shifts; ///< Range adds since the indexes were last caught up, oldest first
+
+        std::vector<int> free_ids;       ///< Removed slots, the last one freed is handed out first
+        std::vector<bool> vacant;        ///< vacant[id] while slot id is on free_ids
+        external_id_map external_ids;    ///< External account ID -> slot
+        std::vector<long long> external_of; ///< Slot -> external ID, meaningful while external_ids maps it back
+        external_order_index external_order; ///< The players of external_ids sorted by external ID
+
+        /**
+         * @brief True if slot id belongs to an account of external_ids.
+         */
+        bool has_external_id(int id) const;
+
+        /**
+         * @brief Keeps external_order current after a write to a player with an external ID.
+         */
+        void external_changed(const player_data &p);
+
+        /**
+         * @brief Places a player in the most recently freed slot, or the next ID.
+         * @param p The player_data to place.
+         * @return The slot, or -1 when the board is full.
+         */
+        int place_player(player_data p);
+
+        /**
+         * @brief True while a slot is removed and not taken again.
+         */
+        bool is_vacant(int id) const;
+
+        /**
+         * @brief Empties the leaf of an ID and recomputes its ancestors.
+         * @param node The pointer to the current node.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param id The slot to empty.
+         */
+        void remove_helper(tree_node* node, int left, int right, int id);
+
+        /**
+         * @brief Gives every node of a subtree back to the pool.
+         * @param node The subtree root.
+         * @param released Counts the nodes given back.
+         */
+        void release_subtree(tree_node* node, int &released);
+
+        /**
+         * @brief Cuts off every subtree that holds removed slots only.
+         * @param node The pointer to the current node, reset to 0 when cut off.
+         * @param released Counts the nodes given back.
+         */
+        void compact_helper(tree_node* &node, int &released);
+
+        /**
+         * @brief Appends the slots of a segment up to reached_index in ID order.
+         * @param node The pointer to the current node; a missing node stands for compacted, removed slots.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param out Receives the players, removed slots as the empty player.
+         * @param above The pending score of the node's ancestors.
+         */
+        void collect_leaves(const tree_node* node, int left, int right, std::vector<player_data> &out, int above = 0) const;
+
+        /**
+         * @brief Doubles the capacity until an ID fits by putting a new root above the tree.
+         *
+         * [0, 2c - 1] splits at c - 1, so every old node keeps its bounds and
+         * nothing is rebuilt.
+         * @param id The ID that must fit.
+         * @return False, with "Leaderboard is full", if the capacity cannot double any further.
+         */
+        bool grow_to_fit(long long id);
+
+        /**
+         * @brief Hands the pending score of a node to its children; every write does it on its way down.
+         * @param node The node.
+         */
+        static void push_down(tree_node* node);
+
+        /**
+         * @brief Writes a leaf and its aggregates.
+         * @param node The leaf.
+         * @param data The player_data it now holds.
+         */
+        static void set_leaf(tree_node* node, const player_data &data);
+
+        /**
+         * @brief Recomputes the best player and the aggregates of a node from its children.
+         * @param node The node.
+         */
+        static void pull(tree_node* node);
+
+        /**
+         * @brief Adds delta to the players of an ID range, tagging the nodes that cover it.
+         * @param node The pointer to the current node.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param start_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @param delta The score to add.
+         */
+        void add_range_helper(tree_node* node, int left, int right, int start_id, int end_id, int delta);
+
+        /**
+         * @brief Collects the nodes that exactly cover an ID range.
+         * @param node The pointer to the current node.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param start_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @param cover Receives the covering nodes.
+         */
+        void cover_nodes(tree_node* node, int left, int right, int start_id, int end_id, std::vector<tree_node*> &cover);
+
+        /**
+         * @brief Writes a sorted slice of updates below a node, then recomputes the node once.
+         * @param node The pointer to the current node.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param first The first update of the slice.
+         * @param last One past the last update of the slice.
+         * @param old Collects the replaced leaves.
+         */
+        void update_batch_helper(tree_node* node, int left, int right, const player_data* first, const player_data* last, std::vector<player_data> &old);
+
+        /**
+         * @brief Builds the nodes covering the first count players, children before parents.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param players The roster.
+         * @param count The number of players in the roster.
+         * @return Pointer to the built node.
+         */
+        tree_node* build_helper(int left, int right, const player_data* players, int count);
 
         /**
          * @brief Inserts a player_data into the segment tree.
@@ -76,13 +949,13 @@ class segment_tree{
         void insert_helper_function(tree_node* &node, int left, int right, int index, player_data data);
 
         /**
-         * @brief Queries the segment tree for the best player within a time range.
+         * @brief Queries the finish_time index for the best player within a time range.
          * @param start_interval The start of the time range.
          * @param end_interval The end of the time range.
          * @return The player_data representing the best player within the time range.
          */
 
-        player_data query_helper_function(tree_node* &node, int start_interval, int end_interval);
+        player_data query_helper_function(int start_interval, int end_interval) const;
 
         /**
          * @brief Updates the player data in the segment tree.
@@ -101,23 +974,64 @@ class segment_tree{
          * @param right The right bound of the current segment.
          * @param start_id The start ID of the player range.
          * @param end_id The end ID of the player range.
+         * @param above The pending score of the node's ancestors, added on the way so queries never write.
          * @return The player_data representing the best player within the ID range.
          */
-        player_data query_by_index_helper(tree_node* &node, int left, int right, int start_id, int end_id);
+        player_data query_by_index_helper(const tree_node* node, int left, int right, int start_id, int end_id, int above = 0) const;
+
+        /**
+         * @brief query_by_index_helper with every aggregate of Agg.
+         * @param node The pointer to the current node.
+         * @param left The left bound of the current segment.
+         * @param right The right bound of the current segment.
+         * @param start_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @param above The pending score of the node's ancestors, applied to the aggregates of a cover node.
+         * @return The best player and the aggregates of the ID range.
+         */
+        range_summary<Agg> summary_helper(const tree_node* node, int left, int right, int start_id, int end_id, int above = 0) const;
 
     public:
 
     /**
      * @brief Constructor for segment_tree.
-     * @param size The size of the segment tree.
+     * @param size The starting capacity; inserts past it double the capacity in O(1).
      */
-        segment_tree(int size);
+        basic_segment_tree(int size);
 
     /**
      * @brief Inserts a player_data into the segment tree.
+     *
+     * The player takes the most recently removed slot if there is one,
+     * the next ID after reached_index otherwise.
      * @param p The player_data to insert.
+     * @return The ID the player got, -1 when the board is frozen or full.
      */
-        void insert_into_tree(player_data p);
+        int insert_into_tree(player_data p);
+
+    /**
+     * @brief Inserts a player under a given ID, for replaying a journal.
+     *
+     * The ID must be a removed slot, which leaves the free list, or the next
+     * ID after reached_index.
+     * @param p The player_data to insert, p.player_id is the slot.
+     * @return False with "Invalid Player ID" for a taken slot or an ID past the next one.
+     */
+        bool insert_at(player_data p);
+
+    /**
+     * @brief Builds the tree from a roster in O(n) with a single node allocation.
+     *
+     * Gives the same tree as calling insert_into_tree for every player in order,
+     * including the IDs: the first players refill the removed slots one at a time,
+     * most recently freed first, and the rest get IDs from reached_index. On a
+     * non-empty tree those are appended in one descent that recomputes every
+     * touched node once.
+     * The capacity doubles as often as the roster needs.
+     * @param players Pointer to the first player of a contiguous roster.
+     * @param count The number of players in the roster.
+     */
+        void build_from(const player_data* players, int count);
 
     /**
      * @brief Queries the segment tree for the best player within a time range.
@@ -125,6 +1039,307 @@ class segment_tree{
      * @param finish_time The end of the time range.
      * @return The player_data representing the best player within the time range.
      */
+        player_data query_the_tree_by_time(int start_time, int finish_time) const;
+
+        /**
+         * @brief Queries the segment tree by player ID range.
+         * @param begin_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @return The player_data representing the best player within the ID range.
+         */
+        player_data query_the_tree_by_id(int begin_id, int end_id) const;
+
+        /**
+         * @brief Best player of an ID range together with every aggregate of Agg, in one O(log n) walk.
+         *
+         * With dashboard_aggregates that is the number of players, their total and
+         * mean score and the earliest finish. A frozen board takes the best from its
+         * sparse_table and folds the aggregates from a heap of ID blocks, also O(log n).
+         * @param begin_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @return The summary, empty with "Invalid ID " or "Invalid Interval" on a bad range.
+         */
+        range_summary<Agg> query_range(int begin_id, int end_id) const;
+
+        /**
+         * @brief query_range over a finish_time range, answered by the finish_time index in O(log n).
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @return The summary, empty with "Wrong Interval" on a negative bound.
+         */
+        range_summary<Agg> query_range_by_time(int start_time, int finish_time) const;
+
+        /**
+         * @brief Returns the k best players within an ID range, best first, in about O(k log n).
+         * @param begin_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @param k The number of players wanted.
+         * @return Up to k players ordered by best_player.
+         */
+        std::vector<player_data> top_k_by_id(int begin_id, int end_id, int k);
+
+        /**
+         * @brief Returns the k best players within a time range, best first, in about O(k log n).
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @param k The number of players wanted.
+         * @return Up to k players ordered by best_player.
+         */
+        std::vector<player_data> top_k_by_time(int start_time, int finish_time, int k) const;
+
+        /**
+         * @brief Global rank of a player under the best_player ordering, in O(log n).
+         * @param player_id The player's ID.
+         * @return The 1-based rank, or -1 for an invalid ID.
+         */
+        int rank_of(int player_id) const;
+
+        /**
+         * @brief The player holding a global rank, in O(log n).
+         * @param rank The 1-based rank.
+         * @return The player, or the empty player for an invalid rank.
+         */
+        player_data player_at(int rank) const;
+
+        /**
+         * @brief Best player with an ID in [begin_id, end_id] who finished in [start_time, finish_time].
+         *
+         * O(log^2 n). The first call builds the two dimensional index, later
+         * inserts and updates keep it current.
+         * @return The best player, or the empty player if none matches or the input is invalid.
+         */
+        player_data query_by_id_and_time(int begin_id, int end_id, int start_time, int finish_time);
+
+        /**
+         * @brief Updates the player data in the segment tree.
+         * @param new_player_data The new player_data to update.
+         * @return True if the update was successful, false otherwise.
+         */
+        bool update_player_data(player_data new_player_data);
+
+        /**
+         * @brief Applies a batch of updates, recomputing each dirty ancestor exactly once.
+         *
+         * Updates to the same player_id are coalesced, the last write wins.
+         * @param updates The batch of updates.
+         * @return Per-item success, as update_player_data would return it.
+         */
+        std::vector<bool> apply_updates(const std::vector<player_data> &updates);
+
+        /**
+         * @brief Adds delta to the score of every player with an ID in [begin_id, end_id], O(log n).
+         *
+         * The O(log n) nodes covering the range take delta as a pending tag, ID
+         * queries add the tags on their path and stay exact. The finish_time,
+         * rank and combined indexes are left as they are and the range is
+         * queued: the next write, or sync_indexes, moves the shifted players.
+         * Until then query_the_tree_by_time, top_k_by_time, rank_of, player_at,
+         * query_range_by_time, query_by_id_and_time and query_by_external_id_range
+         * see the old scores.
+         * Refused with "Leaderboard is frozen" while frozen.
+         * @param begin_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @param delta The score to add, negative for a penalty.
+         * @return True if the range was valid, false otherwise.
+         */
+        bool add_score_range(int begin_id, int end_id, int delta);
+
+        /**
+         * @brief Catches the finish_time, rank, combined and external ID indexes up with the queued range adds.
+         *
+         * Every write calls it first. The queued ranges are merged into runs of
+         * one net delta and their players are moved one by one, O(p log p + k log n)
+         * for p ranges over k players; once k reaches a quarter of the board the
+         * indexes are rebuilt. A writer calls it before handing the board to
+         * readers on other threads (query_batch).
+         */
+        void sync_indexes();
+
+        /**
+         * @brief False while a range add is queued for the indexes.
+         */
+        bool indexes_current() const;
+
+        /**
+         * @brief Removes a player in O(log n) and puts its slot on the free list.
+         *
+         * The leaf becomes the empty player, its ancestors are recomputed and
+         * the player leaves every index. The next insert_into_tree reuses the
+         * slot, so IDs are no longer handed out in order once players leave.
+         * @param player_id The player's ID.
+         * @return False with "Invalid Player ID" for an unknown or already removed ID.
+         */
+        bool remove_player(int player_id);
+
+        /**
+         * @brief Gives the nodes of every subtree holding removed slots only back to the pool, O(nodes).
+         * @return The number of nodes reclaimed.
+         */
+        int compact();
+
+        /**
+         * @brief Number of players on the board, removed ones not counted.
+         */
+        int player_count() const;
+
+        /**
+         * @brief insert_into_tree for a player known by an external account ID; the board keeps the mapping.
+         * @param external_id The caller's 64-bit account ID.
+         * @param p The player_data to insert.
+         * @return The slot, or -1 for an external ID already on the board ("Duplicate External ID") or a full board.
+         */
+        int insert_with_external_id(long long external_id, player_data p);
+
+        /**
+         * @brief Slot of an external ID, one probe of the flat map.
+         * @return The slot, or -1 if the external ID is not on the board.
+         */
+        int slot_of_external_id(long long external_id) const;
+
+        /**
+         * @brief update_player_data addressed by external ID: one probe, then the O(log n) tree walk.
+         * @param external_id The account ID.
+         * @param score The new score.
+         * @param finish_time The new finish_time.
+         * @return False with "Invalid External ID" for an unknown account.
+         */
+        bool update_by_external_id(long long external_id, int score, int finish_time);
+
+        /**
+         * @brief Best player whose external ID is in [begin_external_id, end_external_id], O(log n).
+         *
+         * Answered by external_order, so the result does not depend on the slots
+         * the accounts got. Neither end needs to be on the board. Like the time
+         * reads, it sees range adds once the indexes are caught up (sync_indexes).
+         * @return The best player, the empty player if no account is in the range,
+         *         or with "Invalid Interval" when begin_external_id > end_external_id.
+         */
+        player_data query_by_external_id_range(long long begin_external_id, long long end_external_id) const;
+
+        /**
+         * @brief Current capacity, doubled whenever an insert goes past it.
+         */
+        int size() const;
+
+        /**
+         * @brief ID of the last inserted player, -1 for an empty leaderboard.
+         */
+        int last_index() const;
+
+        /**
+         * @brief Every slot in ID order, gathered in one leaf walk.
+         * @return reached_index + 1 players, removed slots as the empty player; used by save_snapshot and offline_query_batch.
+         */
+        std::vector<player_data> players() const;
+
+        /**
+         * @brief Replaces the ID tree with a sparse_table for read-mostly periods.
+         *
+         * ID queries become two array lookups, top_k_by_id and rank_of keep
+         * working, and the finish_time and rank indexes stay. A board with
+         * aggregates also keeps them for every ID block, 2n values, so
+         * query_range stays O(log n). Inserts and updates are refused with
+         * "Leaderboard is frozen" until thaw.
+         */
+        void freeze();
+
+        /**
+         * @brief Rebuilds the ID tree from the frozen players in O(n).
+         */
+        void thaw();
+
+        /**
+         * @brief True between freeze and thaw.
+         */
+        bool is_frozen() const;
+
+        /**
+         * @brief Bytes held by the frozen form, 0 when the board is not frozen.
+         */
+        size_t frozen_memory_bytes() const;
+
+#ifdef LEADERBOARD_STATS
+        /**
+         * @brief Copy of the per-operation counters: nodes visited, nodes allocated,
+         *        best_player comparisons and a log2 latency histogram.
+         *
+         * Every operation counts privately and adds its counts when it ends, so
+         * reads running on several threads are counted without races.
+         * @return The snapshot, independent of later operations.
+         */
+        tree_stats stats_snapshot() const;
+
+        /**
+         * @brief Sets every counter back to zero.
+         */
+        void reset_stats();
+
+        /**
+         * @brief Writes the counters as CSV, one row per operation type.
+         * @param out The stream to write to.
+         */
+        void export_stats(std::ostream &out) const;
+#endif
+};
+
+typedef basic_segment_tree<no_aggregates> segment_tree;
+
+/**
+*  @brief Segment tree backend stored in one contiguous array.
+*
+*  Exposes the same public interface as segment_tree. Nodes are laid out as an
+*  implicit heap (node i has children 2i and 2i+1, leaves start at capacity),
+*  so the ID tree side of insert, update and query is an iterative loop with
+*  no pointer chasing and no allocation. The finish_time and rank indexes are
+*  the same treaps as in segment_tree: an insert allocates their nodes, and
+*  inserts and updates walk them recursively.
+*/
+class flat_segment_tree{
+    private:
+        std::vector<ranking_key> nodes; ///< Implicit heap of the best players' ranking_keys, index 0 is unused
+        int capacity;           ///< Number of leaves, max_num_of_players rounded up to a power of two
+        int max_num_of_players; ///< Maximum number of players
+        int reached_index;      ///< Index of the last reached player
+        secondary_indexes indexes; ///< finish_time and rank indexes
+
+        /**
+         * @brief Writes a leaf and recomputes its ancestors bottom-up.
+         * @param index The index of the leaf.
+         * @param data The player_data to store.
+         */
+        void set_leaf(int index, player_data data);
+
+    public:
+        /**
+         * @brief Constructor for flat_segment_tree.
+         * @param size The size of the segment tree.
+         */
+        flat_segment_tree(int size);
+
+        /**
+         * @brief Inserts a player_data into the segment tree.
+         * @param p The player_data to insert.
+         */
+        void insert_into_tree(player_data p);
+
+    /**
+     * @brief Builds the tree from a roster in O(n), filling the array bottom-up.
+     *
+     * Gives the same tree as calling insert_into_tree for every player in order,
+     * including the IDs assigned from reached_index. On a non-empty tree the new
+     * leaves are written and only their ancestors are recomputed, level by level.
+     * Players beyond capacity are dropped with "Leaderboard is full".
+     * @param players Pointer to the first player of a contiguous roster.
+     * @param count The number of players in the roster.
+     */
+        void build_from(const player_data* players, int count);
+
+        /**
+         * @brief Queries the segment tree for the best player within a time range.
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @return The player_data representing the best player within the time range.
+         */
         player_data query_the_tree_by_time(int start_time, int finish_time);
 
         /**
@@ -135,10 +1350,75 @@ class segment_tree{
          */
         player_data query_the_tree_by_id(int begin_id, int end_id);
 
+        /**
+         * @brief Returns the k best players within an ID range, best first, in about O(k log n).
+         * @param begin_id The start ID of the player range.
+         * @param end_id The end ID of the player range.
+         * @param k The number of players wanted.
+         * @return Up to k players ordered by best_player.
+         */
+        std::vector<player_data> top_k_by_id(int begin_id, int end_id, int k);
+
+        /**
+         * @brief Returns the k best players within a time range, best first, in about O(k log n).
+         * @param start_time The start of the time range.
+         * @param finish_time The end of the time range.
+         * @param k The number of players wanted.
+         * @return Up to k players ordered by best_player.
+         */
+        std::vector<player_data> top_k_by_time(int start_time, int finish_time, int k);
+
+        /**
+         * @brief Global rank of a player under the best_player ordering, in O(log n).
+         * @param player_id The player's ID.
+         * @return The 1-based rank, or -1 for an invalid ID.
+         */
+        int rank_of(int player_id);
+
+        /**
+         * @brief The player holding a global rank, in O(log n).
+         * @param rank The 1-based rank.
+         * @return The player, or the empty player for an invalid rank.
+         */
+        player_data player_at(int rank);
+
+        /**
+         * @brief Best player with an ID in [begin_id, end_id] who finished in [start_time, finish_time].
+         *
+         * O(log^2 n). The first call builds the two dimensional index, later
+         * inserts and updates keep it current.
+         * @return The best player, or the empty player if none matches or the input is invalid.
+         */
+        player_data query_by_id_and_time(int begin_id, int end_id, int start_time, int finish_time);
+
         /**
          * @brief Updates the player data in the segment tree.
          * @param new_player_data The new player_data to update.
          * @return True if the update was successful, false otherwise.
          */
         bool update_player_data(player_data new_player_data);
+
+        /**
+         * @brief Applies a batch of updates, recomputing each dirty ancestor exactly once.
+         *
+         * Updates to the same player_id are coalesced, the last write wins.
+         * @param updates The batch of updates.
+         * @return Per-item success, as update_player_data would return it.
+         */
+        std::vector<bool> apply_updates(const std::vector<player_data> &updates);
+
+        /**
+         * @brief Maximum number of players the leaderboard was created for.
+         */
+        int size() const;
+
+        /**
+         * @brief ID of the last inserted player, -1 for an empty leaderboard.
+         */
+        int last_index() const;
+
+        /**
+         * @brief Every inserted player in ID order, copied from the used leaves.
+         */
+        std::vector<player_data> players() const;
 };
\ No newline at end of file
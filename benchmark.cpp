@@ -0,0 +1,1161 @@
+#include "project.cpp"
+#include "concurrent_leaderboard.cpp"
+#include "sharded_leaderboard.cpp"
+#include "query_batch.cpp"
+#include "leaderboard_snapshot.cpp"
+#include "write_ahead_log.cpp"
+#include "stream_ingest.cpp"
+#include "sliding_window_leaderboard.cpp"
+#include "golden_model.cpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// ================= Timing =================
+typedef chrono::steady_clock bench_clock;
+
+double seconds_since(bench_clock::time_point start) {
+    return chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+long long nanoseconds_since(bench_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(bench_clock::now() - start).count();
+}
+
+// ================= Memory =================
+// Linux only : one "VmXXX:" line of /proc/self/status in KB , 0 where /proc is not available
+long long status_kb(const char *field) {
+    ifstream status("/proc/self/status");
+    string line;
+    size_t length = strlen(field);
+    while (getline(status, line)) {
+        if (line.compare(0, length, field) == 0) return atoll(line.c_str() + length);
+    }
+    return 0;
+}
+
+// resident set size when the current measurement started , the workload and latency buffers are already in it
+long long rss_baseline_kb = 0;
+
+// lets every measurement report its own peak instead of the peak of the whole run , and only what it added
+// on top of the harness : at 10^7 players the roster and latency buffers alone are over 100 MB
+void reset_peak_rss() {
+#ifdef __GLIBC__
+    // hand pages freed by the previous measurement back to the kernel , or they sit in the baseline
+    malloc_trim(0);
+#endif
+    {
+        ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+    }
+    rss_baseline_kb = status_kb("VmRSS:");
+}
+
+// peak resident set size (VmHWM) above the baseline of the last reset_peak_rss
+long long peak_rss_kb() {
+    long long peak = status_kb("VmHWM:") - rss_baseline_kb;
+    return peak > 0 ? peak : 0;
+}
+
+// writes every page of a latency buffer up front , so it is resident before reset_peak_rss takes its baseline
+void prefault(vector<long long> &latencies, size_t count) {
+    latencies.assign(count, 0);
+    latencies.clear();
+}
+
+// ================= Results =================
+struct bench_result {
+    string backend;
+    string operation;
+    int players;
+    long long ops;
+    double seconds;
+    long long p50_ns;   // 0 when latencies were not sampled
+    long long p99_ns;
+    long long peak_rss_kb;  // above the resident set the harness had when the measurement started
+};
+
+vector<bench_result> results;
+
+long long percentile(vector<long long> &latencies, double fraction) {
+    if (latencies.empty()) return 0;
+    size_t k = (size_t)(fraction * (latencies.size() - 1));
+    nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+    return latencies[k];
+}
+
+void record(const string &backend, const string &operation, int num_players,
+            long long ops, double seconds, const vector<long long> &latencies) {
+    bench_result r;
+    // read before the percentiles copy the latencies , so the copy is not counted
+    r.peak_rss_kb = peak_rss_kb();
+    r.backend = backend;
+    r.operation = operation;
+    r.players = num_players;
+    r.ops = ops;
+    r.seconds = seconds;
+    vector<long long> sorted(latencies);
+    r.p50_ns = percentile(sorted, 0.50);
+    r.p99_ns = percentile(sorted, 0.99);
+    results.push_back(r);
+
+    cout << setw(10) << left << backend
+         << setw(9) << left << operation
+         << " players: " << setw(9) << num_players
+         << " ops: " << setw(9) << ops
+         << " ops/sec: " << fixed << setprecision(0) << setw(11) << (ops / seconds)
+         << " p50(ns): " << setw(8) << r.p50_ns
+         << " p99(ns): " << setw(8) << r.p99_ns
+         << " peak rss(KB): +" << r.peak_rss_kb << endl;
+}
+
+// one CSV row per measurement , stable columns so runs of different versions can be diffed
+void write_csv(const string &path) {
+    ofstream out(path.c_str());
+    out << "backend,operation,players,ops,seconds,ops_per_sec,p50_ns,p99_ns,peak_rss_kb\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const bench_result &r = results[i];
+        out << r.backend << ',' << r.operation << ',' << r.players << ',' << r.ops << ','
+            << fixed << setprecision(6) << r.seconds << ',' << setprecision(0) << (r.ops / r.seconds) << ','
+            << r.p50_ns << ',' << r.p99_ns << ',' << r.peak_rss_kb << '\n';
+    }
+}
+
+// ================= Golden Backend =================
+// golden_model behind the segment_tree interface , ids are assigned like reached_index does
+class golden_backend {
+public:
+    golden_backend(int) : reached_index(-1) {}
+
+    void insert_into_tree(player_data p) {
+        reached_index++;
+        model.add_player(player_data(p.score, reached_index, p.finish_time));
+    }
+    bool update_player_data(player_data p) { return model.update_player(p); }
+    player_data query_the_tree_by_id(int begin_id, int end_id) { return model.query_by_id(begin_id, end_id); }
+    player_data query_the_tree_by_time(int start_time, int finish_time) { return model.query_by_time(start_time, finish_time); }
+
+private:
+    golden_model model;
+    int reached_index;
+};
+
+// ================= Core Benchmark =================
+// Tree is any backend with the segment_tree interface , every backend sees the same fixed-seed workload
+// every operation is timed on its own for the latency percentiles
+template <class Tree>
+void bench_core(const string &backend, int num_players, int num_ops) {
+    srand(42);
+    vector<long long> latencies;
+    long long checksum = 0;
+
+    prefault(latencies, max(num_players, num_ops));
+    reset_peak_rss();
+    Tree *leaderboard = new Tree(num_players);
+
+    bench_clock::time_point start = bench_clock::now();
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        bench_clock::time_point op = bench_clock::now();
+        leaderboard->insert_into_tree(p);
+        latencies.push_back(nanoseconds_since(op));
+    }
+    record(backend, "insert", num_players, num_players, seconds_since(start), latencies);
+
+    latencies.clear();
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        player_data p(rand() % 1000, rand() % num_players, rand() % 1000);
+        bench_clock::time_point op = bench_clock::now();
+        leaderboard->update_player_data(p);
+        latencies.push_back(nanoseconds_since(op));
+    }
+    record(backend, "update", num_players, num_ops, seconds_since(start), latencies);
+
+    latencies.clear();
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        bench_clock::time_point op = bench_clock::now();
+        checksum += leaderboard->query_the_tree_by_id(id1, id2).player_id;
+        latencies.push_back(nanoseconds_since(op));
+    }
+    record(backend, "by_id", num_players, num_ops, seconds_since(start), latencies);
+
+    latencies.clear();
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        bench_clock::time_point op = bench_clock::now();
+        checksum += leaderboard->query_the_tree_by_time(t1, t2).player_id;
+        latencies.push_back(nanoseconds_since(op));
+    }
+    record(backend, "by_time", num_players, num_ops, seconds_since(start), latencies);
+
+    // same seed and same workload , so backends run with the same num_ops must print the same checksum
+    cout << "checksum: " << checksum << endl;
+    delete leaderboard;
+}
+
+// the finish_time and rank indexes alone , fed the workload of bench_core : both backends keep them as pointer
+// treaps , so this is the part of an insert or update that the flat array does not change
+void bench_index_share(int num_players, int num_ops) {
+    srand(42);
+    vector<long long> latencies;
+
+    vector<player_data> current(num_players);
+    prefault(latencies, max(num_players, num_ops));
+    reset_peak_rss();
+    secondary_indexes *indexes = new secondary_indexes();
+
+    bench_clock::time_point start = bench_clock::now();
+    for (int i = 0; i < num_players; ++i) {
+        player_data p(rand() % 1000, i, rand() % 1000);
+        bench_clock::time_point op = bench_clock::now();
+        indexes->add(p);
+        latencies.push_back(nanoseconds_since(op));
+        current[i] = p;
+    }
+    record("indexes", "insert", num_players, num_players, seconds_since(start), latencies);
+
+    latencies.clear();
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        player_data p(rand() % 1000, rand() % num_players, rand() % 1000);
+        bench_clock::time_point op = bench_clock::now();
+        indexes->replace(current[p.player_id], p);
+        latencies.push_back(nanoseconds_since(op));
+        current[p.player_id] = p;
+    }
+    record("indexes", "update", num_players, num_ops, seconds_since(start), latencies);
+    delete indexes;
+}
+
+// ================= Cold Start Benchmark =================
+// one insert_into_tree per player against a single build_from over the same roster
+template <class Tree>
+void bench_cold_start(const string &backend, int num_players) {
+    srand(7);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+    }
+
+    reset_peak_rss();
+    Tree *leaderboard = new Tree(num_players);
+    bench_clock::time_point start = bench_clock::now();
+    for (int i = 0; i < num_players; ++i) {
+        leaderboard->insert_into_tree(roster[i]);
+    }
+    record(backend, "inserts", num_players, num_players, seconds_since(start), vector<long long>());
+    delete leaderboard;
+
+    reset_peak_rss();
+    leaderboard = new Tree(num_players);
+    start = bench_clock::now();
+    leaderboard->build_from(roster.data(), num_players);
+    record(backend, "build", num_players, num_players, seconds_since(start), vector<long long>());
+    delete leaderboard;
+}
+
+// ================= Snapshot Benchmark =================
+// restart paths : replaying every insert , reopening a snapshot through mmap , and restoring a writable tree from it
+void bench_snapshot(int num_players, const string &path) {
+    srand(7);
+    segment_tree *leaderboard = new segment_tree(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        leaderboard->insert_into_tree(player_data(rand() % 1000, -1, rand() % 1000));
+    }
+
+    bench_clock::time_point start = bench_clock::now();
+    save_snapshot(*leaderboard, path);
+    record("snapshot", "save", num_players, 1, seconds_since(start), vector<long long>());
+    delete leaderboard;
+
+    // open plus the first answer is what a restarted server waits for
+    reset_peak_rss();
+    start = bench_clock::now();
+    {
+        mapped_leaderboard mapped(path);
+        mapped.query_the_tree_by_id(0, num_players - 1);
+        record("snapshot", "open_and_query", num_players, 1, seconds_since(start), vector<long long>());
+
+        int queries = 100000;
+        vector<long long> latencies(queries);
+        start = bench_clock::now();
+        for (int i = 0; i < queries; ++i) {
+            int id1 = rand() % num_players;
+            int id2 = id1 + rand() % (num_players - id1);
+            bench_clock::time_point begin = bench_clock::now();
+            mapped.query_the_tree_by_id(id1, id2);
+            latencies[i] = nanoseconds_since(begin);
+        }
+        record("snapshot", "mapped_query_by_id", num_players, queries, seconds_since(start), latencies);
+
+        reset_peak_rss();
+        start = bench_clock::now();
+        segment_tree restored(mapped.size());
+        mapped.restore_into(restored);
+        record("snapshot", "restore", num_players, num_players, seconds_since(start), vector<long long>());
+    }
+    remove(path.c_str());
+}
+
+// ================= Batch Update Benchmark =================
+// end of match traffic : batches of score changes , applied one by one and through apply_updates
+template <class Tree>
+void bench_batch_updates(const string &backend, int num_players, int batch_size, int num_batches) {
+    srand(11);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+    }
+    vector<vector<player_data> > batches(num_batches);
+    for (int b = 0; b < num_batches; ++b) {
+        for (int i = 0; i < batch_size; ++i) {
+            batches[b].push_back(player_data(rand() % 1000, rand() % num_players, rand() % 1000));
+        }
+    }
+    long long ops = (long long)batch_size * num_batches;
+
+    Tree *leaderboard = new Tree(num_players);
+    leaderboard->build_from(roster.data(), num_players);
+    bench_clock::time_point start = bench_clock::now();
+    for (int b = 0; b < num_batches; ++b) {
+        for (int i = 0; i < batch_size; ++i) {
+            leaderboard->update_player_data(batches[b][i]);
+        }
+    }
+    record(backend, "single", num_players, ops, seconds_since(start), vector<long long>());
+    delete leaderboard;
+
+    leaderboard = new Tree(num_players);
+    leaderboard->build_from(roster.data(), num_players);
+    start = bench_clock::now();
+    for (int b = 0; b < num_batches; ++b) {
+        leaderboard->apply_updates(batches[b]);
+    }
+    record(backend, "batched", num_players, ops, seconds_since(start), vector<long long>());
+    delete leaderboard;
+}
+
+// ================= Concurrent Read Benchmark =================
+// lock free readers against one writer applying updates_per_sec updates , reported for 1 , 2 , 4 ... readers
+void bench_concurrent_reads(int num_players, int updates_per_sec, double seconds) {
+    srand(13);
+    concurrent_leaderboard leaderboard(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        leaderboard.insert_into_tree(player_data(rand() % 1000, i, rand() % 1000));
+    }
+
+    int max_readers = (int)thread::hardware_concurrency();
+    if (max_readers < 1) max_readers = 1;
+
+    for (int num_readers = 1; num_readers <= max_readers; num_readers *= 2) {
+        atomic<bool> done(false);
+        atomic<long long> reads(0);
+        long long writes = 0;
+
+        vector<thread> readers;
+        for (int r = 0; r < num_readers; ++r) {
+            readers.push_back(thread([&, r]() {
+                unsigned state = 777u + r;
+                long long local = 0;
+                while (!done.load(memory_order_relaxed)) {
+                    state = state * 1103515245u + 12345u;
+                    int id1 = (state >> 8) % num_players;
+                    int id2 = id1 + (int)((state >> 4) % (num_players - id1));
+                    leaderboard.query_the_tree_by_id(id1, id2);
+                    int t1 = (state >> 12) % 1000;
+                    leaderboard.query_the_tree_by_time(t1, t1 + 100);
+                    local += 2;
+                }
+                reads += local;
+            }));
+        }
+
+        // the writer paces itself to a fixed update rate
+        bench_clock::time_point start = bench_clock::now();
+        chrono::nanoseconds gap(1000000000LL / updates_per_sec);
+        bench_clock::time_point next = start;
+        while (seconds_since(start) < seconds) {
+            leaderboard.update_player_data(player_data(rand() % 1000, rand() % num_players, rand() % 1000));
+            writes++;
+            next += gap;
+            this_thread::sleep_until(next);
+        }
+        done.store(true);
+        for (size_t r = 0; r < readers.size(); ++r) readers[r].join();
+        double elapsed = seconds_since(start);
+
+        string backend = "readers_" + to_string(num_readers);
+        record(backend, "read", num_players, reads.load(), elapsed, vector<long long>());
+        record(backend, "write", num_players, writes, elapsed, vector<long long>());
+    }
+}
+
+// ================= Sharded Suite =================
+// one writer thread per shard hammers updates , throughput should grow with the shard count up to the core count
+void bench_sharded(int num_players, int ops) {
+    int max_shards = (int)thread::hardware_concurrency();
+    if (max_shards < 1) max_shards = 1;
+
+    for (int num_shards = 1; num_shards <= max_shards; num_shards *= 2) {
+        srand(17);
+        sharded_leaderboard leaderboard(num_players, num_shards);
+        for (int i = 0; i < num_players; ++i) {
+            leaderboard.insert_into_tree(player_data(rand() % 1000, i, rand() % 1000));
+        }
+
+        // writer w only touches players of shard w , so writers never wait on each other
+        int per_writer = ops / num_shards;
+        bench_clock::time_point start = bench_clock::now();
+        vector<thread> writers;
+        for (int w = 0; w < num_shards; ++w) {
+            writers.push_back(thread([&, w]() {
+                unsigned state = 4242u + w;
+                int owned = (num_players - w + num_shards - 1) / num_shards;
+                if (owned < 1) return;
+                for (int i = 0; i < per_writer; ++i) {
+                    state = state * 1103515245u + 12345u;
+                    int id = (int)((state >> 8) % owned) * num_shards + w;
+                    leaderboard.update_player_data(player_data((state >> 4) % 1000, id, (state >> 12) % 1000));
+                }
+            }));
+        }
+        for (size_t w = 0; w < writers.size(); ++w) writers[w].join();
+        double elapsed = seconds_since(start);
+
+        string backend = "shards_" + to_string(num_shards);
+        record(backend, "update", num_players, (long long)per_writer * num_shards, elapsed, vector<long long>());
+
+        start = bench_clock::now();
+        int queries = ops / 10;
+        for (int i = 0; i < queries; ++i) {
+            int t1 = rand() % 1000;
+            leaderboard.query_the_tree_by_time(t1, t1 + 100);
+        }
+        record(backend, "query_by_time", num_players, queries, seconds_since(start), vector<long long>());
+    }
+}
+
+// ================= Query Batch Suite =================
+// the same read only bursts answered on pools of 1 ... hardware_concurrency workers
+void bench_query_batch(int num_players, int ops) {
+    srand(19);
+    segment_tree leaderboard(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        leaderboard.insert_into_tree(player_data(rand() % 1000, i, rand() % 1000));
+    }
+
+    vector<range_query> queries;
+    for (int i = 0; i < ops; ++i) {
+        if (i % 2) {
+            int low = rand() % num_players;
+            queries.push_back(range_query(by_id, low, low + rand() % (num_players - low)));
+        } else {
+            int low = rand() % 1000;
+            queries.push_back(range_query(by_time, low, low + 100));
+        }
+    }
+
+    int max_workers = (int)thread::hardware_concurrency();
+    if (max_workers < 1) max_workers = 1;
+
+    for (int num_workers = 1; num_workers <= max_workers; num_workers *= 2) {
+        thread_pool pool(num_workers);
+        bench_clock::time_point start = bench_clock::now();
+        vector<player_data> results = query_batch(pool, leaderboard, queries);
+        double elapsed = seconds_since(start);
+
+        string backend = "workers_" + to_string(num_workers);
+        record(backend, "query_batch", num_players, (long long)results.size(), elapsed, vector<long long>());
+    }
+
+    // the same burst one query at a time , and answered offline in one sweep per kind
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const range_query &q = queries[i];
+        if (q.kind == by_id) leaderboard.query_the_tree_by_id(q.low, q.high);
+        else leaderboard.query_the_tree_by_time(q.low, q.high);
+    }
+    record("online", "query_batch", num_players, (long long)queries.size(), seconds_since(start), vector<long long>());
+
+    start = bench_clock::now();
+    vector<player_data> results = offline_query_batch(leaderboard, queries);
+    record("offline_sweep", "query_batch", num_players, (long long)results.size(), seconds_since(start), vector<long long>());
+}
+
+// ================= Journal Suite =================
+// update throughput with every mutation journaled , one fsync per group , against the same tree without a journal
+void bench_journal(int num_players, int ops, const string &path) {
+    const int group_sizes[] = {1, 64, 1024};
+    for (int g = -1; g < 3; ++g) {
+        string log_path = path + ".journal", snapshot_path = path + ".snapshot";
+        remove(log_path.c_str());
+        remove(snapshot_path.c_str());
+        srand(23);
+
+        // group size 1 pays one fsync per update , fewer ops keep it from dominating the run
+        int updates = g == 0 ? min(ops, 2000) : ops;
+        string backend = g < 0 ? string("no_journal") : "group_" + to_string(group_sizes[g]);
+        journaled_leaderboard *journaled = 0;
+        segment_tree *plain = 0;
+        if (g < 0) plain = new segment_tree(num_players);
+        else journaled = new journaled_leaderboard(num_players, log_path, snapshot_path, group_sizes[g], 5);
+
+        vector<player_data> roster(num_players);
+        for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+        if (plain) plain->build_from(roster.data(), num_players);
+        else {
+            for (int i = 0; i < num_players; ++i) journaled->insert_into_tree(roster[i]);
+            journaled->compact();
+        }
+
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < updates; ++i) {
+            player_data p(rand() % 1000, rand() % num_players, rand() % 1000);
+            if (plain) plain->update_player_data(p);
+            else {
+                journaled->update_player_data(p);
+                if (group_sizes[g] == 1) journaled->sync(); // every update acknowledged only once it is durable
+            }
+        }
+        if (journaled) journaled->sync();
+        record(backend, "durable_update", num_players, updates, seconds_since(start), vector<long long>());
+        delete plain;
+        delete journaled;
+
+        if (g >= 0) {
+            start = bench_clock::now();
+            journaled = new journaled_leaderboard(num_players, log_path, snapshot_path);
+            record(backend, "replay", num_players, updates, seconds_since(start), vector<long long>());
+            delete journaled;
+        }
+        remove(log_path.c_str());
+        remove(snapshot_path.c_str());
+    }
+}
+
+// ================= Ingest Suite =================
+// rows/sec loading a dump : fscanf plus insert_into_tree per row , then the chunked csv and binary ingest paths
+void bench_ingest(int num_players, const string &path) {
+    srand(29);
+    string csv_path = path + ".ingest.csv", binary_path = path + ".ingest.bin";
+    {
+        FILE* csv = fopen(csv_path.c_str(), "wb");
+        FILE* binary = fopen(binary_path.c_str(), "wb");
+        for (int i = 0; i < num_players; ++i) {
+            int row[2] = {rand() % 100000, rand() % 100000};
+            fprintf(csv, "%d,%d\n", row[0], row[1]);
+            fwrite(row, sizeof(int), 2, binary);
+        }
+        fclose(csv);
+        fclose(binary);
+    }
+
+    {
+        reset_peak_rss();
+        segment_tree leaderboard(num_players);
+        bench_clock::time_point start = bench_clock::now();
+        FILE* csv = fopen(csv_path.c_str(), "rb");
+        int score, finish_time;
+        long long rows = 0;
+        while (fscanf(csv, "%d,%d", &score, &finish_time) == 2) {
+            leaderboard.insert_into_tree(player_data(score, -1, finish_time));
+            rows++;
+        }
+        fclose(csv);
+        record("fscanf_insert", "csv", num_players, rows, seconds_since(start), vector<long long>());
+    }
+
+    const ingest_format formats[] = {ingest_csv, ingest_binary};
+    for (int f = 0; f < 2; ++f) {
+        const string &file = formats[f] == ingest_csv ? csv_path : binary_path;
+        const string name = formats[f] == ingest_csv ? "csv" : "binary";
+        {
+            reset_peak_rss();
+            segment_tree leaderboard(num_players);
+            int fd = open(file.c_str(), O_RDONLY);
+            ingest_stats stats = ingest_fd(leaderboard, fd, formats[f]);
+            close(fd);
+            record("ingest_fd", name, num_players, stats.rows, stats.seconds, vector<long long>());
+        }
+        {
+            reset_peak_rss();
+            segment_tree leaderboard(num_players);
+            ingest_stats stats = ingest_mapped(leaderboard, file, formats[f]);
+            record("ingest_mapped", name, num_players, stats.rows, stats.seconds, vector<long long>());
+        }
+    }
+    remove(csv_path.c_str());
+    remove(binary_path.c_str());
+}
+
+// ================= ID and Time Suite =================
+// combined ID range and time window queries : building the 2D index , then queries and updates with it in place
+template <class Tree>
+void bench_id_time(const string &backend, int num_players, int num_ops) {
+    srand(31);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+
+    vector<long long> latencies;
+    prefault(latencies, num_ops);
+    reset_peak_rss();
+    Tree *leaderboard = new Tree(num_players);
+    leaderboard->build_from(roster.data(), num_players);
+
+    // the first combined query pays for the index
+    bench_clock::time_point start = bench_clock::now();
+    leaderboard->query_by_id_and_time(0, num_players - 1, 0, 999);
+    record(backend, "build_2d", num_players, num_players, seconds_since(start), vector<long long>());
+
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        if (id1 > id2) swap(id1, id2);
+        int t1 = rand() % 1000, t2 = rand() % 1000;
+        if (t1 > t2) swap(t1, t2);
+        bench_clock::time_point op = bench_clock::now();
+        leaderboard->query_by_id_and_time(id1, id2, t1, t2);
+        latencies.push_back(nanoseconds_since(op));
+    }
+    record(backend, "by_id_and_time", num_players, num_ops, seconds_since(start), latencies);
+
+    latencies.clear();
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        player_data p(rand() % 1000, rand() % num_players, rand() % 1000);
+        bench_clock::time_point op = bench_clock::now();
+        leaderboard->update_player_data(p);
+        latencies.push_back(nanoseconds_since(op));
+    }
+    record(backend, "update_with_2d", num_players, num_ops, seconds_since(start), latencies);
+    delete leaderboard;
+}
+
+// ================= Sliding Window Suite =================
+// a stream of finishes with a "best in the last window" read after each one : the sliding board against a
+// segment_tree that keeps every player and asks query_the_tree_by_time(now - window , now)
+void bench_sliding_window(int num_players, int window) {
+    srand(37);
+    vector<player_data> stream(num_players);
+    for (int i = 0; i < num_players; ++i) {
+        // about ten finishes per time unit , a few arriving late
+        stream[i] = player_data(rand() % 100000, -1, max(0, i / 10 - rand() % 5));
+    }
+
+    long long checksum = 0;
+    {
+        reset_peak_rss();
+        segment_tree leaderboard(num_players);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_players; ++i) {
+            leaderboard.insert_into_tree(stream[i]);
+            int now = i / 10;
+            checksum += leaderboard.query_the_tree_by_time(max(0, now - window + 1), now).score;
+        }
+        record("emulated", "insert_and_best", num_players, num_players, seconds_since(start), vector<long long>());
+    }
+    {
+        reset_peak_rss();
+        sliding_window_leaderboard leaderboard(window, max(1, window / 64));
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_players; ++i) {
+            leaderboard.advance(i / 10);
+            leaderboard.insert_into_tree(stream[i]);
+            checksum += leaderboard.best().score;
+        }
+        record("sliding", "insert_and_best", num_players, num_players, seconds_since(start), vector<long long>());
+
+        int queries = 10000;
+        start = bench_clock::now();
+        for (int i = 0; i < queries; ++i) checksum += leaderboard.top_k(10).size();
+        record("sliding", "top_10", num_players, queries, seconds_since(start), vector<long long>());
+    }
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Freeze Suite =================
+// ID range queries on the pointer tree , then on the same board frozen into a sparse_table
+void bench_freeze(int num_players, int num_ops) {
+    srand(41);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+    segment_tree leaderboard(num_players);
+    leaderboard.build_from(roster.data(), num_players);
+
+    vector<pair<int, int> > ranges(num_ops);
+    for (int i = 0; i < num_ops; ++i) {
+        int id1 = rand() % num_players, id2 = rand() % num_players;
+        ranges[i] = make_pair(min(id1, id2), max(id1, id2));
+    }
+
+    long long checksum = 0;
+    for (int frozen = 0; frozen < 2; ++frozen) {
+        string backend = frozen ? "frozen" : "pointer";
+        if (frozen) {
+            bench_clock::time_point start = bench_clock::now();
+            leaderboard.freeze();
+            record(backend, "freeze", num_players, num_players, seconds_since(start), vector<long long>());
+            cout << "frozen form: " << leaderboard.frozen_memory_bytes() / 1024 << " KB ("
+                 << fixed << setprecision(1) << (double)leaderboard.frozen_memory_bytes() / num_players
+                 << " bytes per player)" << endl;
+        }
+
+        vector<long long> latencies;
+        latencies.reserve(num_ops);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            checksum += leaderboard.query_the_tree_by_id(ranges[i].first, ranges[i].second).player_id;
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record(backend, "by_id", num_players, num_ops, seconds_since(start), latencies);
+    }
+
+    bench_clock::time_point start = bench_clock::now();
+    leaderboard.thaw();
+    record("frozen", "thaw", num_players, num_players, seconds_since(start), vector<long long>());
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Range Add Suite =================
+// the same bonus given to blocks of 1000 IDs , one update_player_data per player against one add_score_range ,
+// which tags the ID tree in O(log n) and queues the block for the finish_time and rank indexes
+// lazy leaves the queue to one sync_indexes after the run (its own row) , synced catches up after every range add
+void bench_range_add(int num_players, int num_ops) {
+    srand(43);
+    const int block = min(1000, num_players);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+
+    long long checksum = 0;
+    const char *backends[] = {"per_player", "lazy", "synced"};
+    for (int lazy = 0; lazy < 3; ++lazy) {
+        segment_tree leaderboard(num_players);
+        leaderboard.build_from(roster.data(), num_players);
+        // both sides move every player of the block in the indexes , keep the runs short
+        int ops = max(1, min(num_ops, 200000 / block));
+
+        vector<long long> latencies;
+        latencies.reserve(ops);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < ops; ++i) {
+            int first = rand() % (num_players - block + 1);
+            bench_clock::time_point op = bench_clock::now();
+            if (lazy) {
+                leaderboard.add_score_range(first, first + block - 1, 50);
+                if (lazy == 2) leaderboard.sync_indexes();
+            } else {
+                for (int id = first; id < first + block; ++id) {
+                    player_data p = leaderboard.query_the_tree_by_id(id, id);
+                    leaderboard.update_player_data(player_data(p.score + 50, id, p.finish_time));
+                }
+            }
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record(backends[lazy], "range_add", num_players, ops, seconds_since(start), latencies);
+        if (lazy == 1) {
+            start = bench_clock::now();
+            leaderboard.sync_indexes();
+            record(backends[lazy], "sync", num_players, 1, seconds_since(start), vector<long long>());
+        }
+
+        checksum += leaderboard.query_the_tree_by_time(0, 999).player_id;
+        checksum += leaderboard.query_the_tree_by_id(0, num_players - 1).score;
+    }
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Growth Suite =================
+// inserts into a board sized 10x too big (the old safety margin) , sized exactly , and grown from one player
+void bench_growth(int num_players) {
+    srand(47);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+
+    const char *backends[] = {"oversized", "presized", "growing"};
+    long long capacities[] = {10LL * num_players, num_players, 1};
+    long long checksum = 0;
+    for (int b = 0; b < 3; ++b) {
+        if (capacities[b] > INT_MAX) continue;
+        vector<long long> latencies;
+        prefault(latencies, num_players);
+        reset_peak_rss();
+        segment_tree *leaderboard = new segment_tree((int)capacities[b]);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_players; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            leaderboard->insert_into_tree(roster[i]);
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record(backends[b], "inserts", num_players, num_players, seconds_since(start), latencies);
+        checksum += leaderboard->query_the_tree_by_id(0, num_players - 1).player_id + leaderboard->size();
+        delete leaderboard;
+    }
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Churn Suite =================
+// players leave and new ones take their slots , the board size stays flat , then compaction after a mass ban
+void bench_churn(int num_players, int num_ops) {
+    srand(53);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, -1, rand() % 1000);
+    segment_tree leaderboard(num_players);
+    leaderboard.build_from(roster.data(), num_players);
+
+    vector<long long> remove_latencies, insert_latencies;
+    remove_latencies.reserve(num_ops);
+    insert_latencies.reserve(num_ops);
+    double remove_seconds = 0, insert_seconds = 0;
+    for (int i = 0; i < num_ops; ++i) {
+        bench_clock::time_point op = bench_clock::now();
+        leaderboard.remove_player(rand() % num_players);
+        remove_latencies.push_back(nanoseconds_since(op));
+        remove_seconds += remove_latencies.back() / 1e9;
+
+        op = bench_clock::now();
+        leaderboard.insert_into_tree(player_data(rand() % 1000, -1, rand() % 1000));
+        insert_latencies.push_back(nanoseconds_since(op));
+        insert_seconds += insert_latencies.back() / 1e9;
+    }
+    record("pointer", "remove", num_players, num_ops, remove_seconds, remove_latencies);
+    record("pointer", "reinsert", num_players, num_ops, insert_seconds, insert_latencies);
+
+    // ban the first half , then give the emptied subtrees back
+    bench_clock::time_point start = bench_clock::now();
+    for (int id = 0; id < num_players / 2; ++id) leaderboard.remove_player(id);
+    record("pointer", "ban_half", num_players, num_players / 2, seconds_since(start), vector<long long>());
+    start = bench_clock::now();
+    int released = leaderboard.compact();
+    record("pointer", "compact", num_players, released, seconds_since(start), vector<long long>());
+    cout << "checksum: " << leaderboard.query_the_tree_by_id(0, num_players - 1).player_id + released << endl;
+}
+
+// ================= External ID Suite =================
+// updates addressed by 64 bit account IDs : a side std::unordered_map plus update_player_data ,
+// against the board's own flat map through update_by_external_id , which also keeps the external ID order current ,
+// then ranges of account IDs answered from that order
+void bench_external_ids(int num_players, int num_ops) {
+    srand(59);
+    vector<long long> accounts(num_players);
+    for (int i = 0; i < num_players; ++i) accounts[i] = ((long long)rand() << 31) ^ rand();
+
+    vector<int> picks(num_ops), scores(num_ops);
+    for (int i = 0; i < num_ops; ++i) {
+        picks[i] = rand() % num_players;
+        scores[i] = rand() % 1000;
+    }
+
+    long long checksum = 0;
+    for (int owned = 0; owned < 2; ++owned) {
+        segment_tree leaderboard(num_players);
+        unordered_map<long long, int> side;
+        for (int i = 0; i < num_players; ++i) {
+            player_data p(rand() % 1000, -1, rand() % 1000);
+            if (owned) {
+                leaderboard.insert_with_external_id(accounts[i], p);
+            } else {
+                leaderboard.insert_into_tree(p);
+                side[accounts[i]] = leaderboard.last_index();
+            }
+        }
+
+        vector<long long> latencies;
+        latencies.reserve(num_ops);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            long long account = accounts[picks[i]];
+            bench_clock::time_point op = bench_clock::now();
+            if (owned) {
+                leaderboard.update_by_external_id(account, scores[i], i % 1000);
+            } else {
+                leaderboard.update_player_data(player_data(scores[i], side.find(account)->second, i % 1000));
+            }
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record(owned ? "flat_map" : "std_map", "update", num_players, num_ops, seconds_since(start), latencies);
+        checksum += leaderboard.query_the_tree_by_id(0, num_players - 1).player_id;
+        if (!owned) continue;
+
+        latencies.clear();
+        start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            long long a = accounts[picks[i]], b = accounts[picks[(i + 1) % num_ops]];
+            if (a > b) swap(a, b);
+            bench_clock::time_point op = bench_clock::now();
+            checksum += leaderboard.query_by_external_id_range(a, b).player_id;
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record("flat_map", "external_range", num_players, num_ops, seconds_since(start), latencies);
+    }
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Aggregates Suite =================
+// count , total and earliest finish of an ID range next to its best player : a scan over a side copy of the
+// players plus query_the_tree_by_id , against one query_range on a dashboard_aggregates board
+// updates are timed on both boards too , the price of keeping the aggregates in every node
+void bench_aggregates(int num_players, int num_ops) {
+    srand(61);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, i, rand() % 1000);
+    vector<int> lows(num_ops), highs(num_ops);
+    vector<player_data> updates(num_ops);
+    for (int i = 0; i < num_ops; ++i) {
+        lows[i] = rand() % num_players;
+        highs[i] = rand() % num_players;
+        if (lows[i] > highs[i]) swap(lows[i], highs[i]);
+        updates[i] = player_data(rand() % 1000, rand() % num_players, rand() % 1000);
+    }
+
+    long long checksum = 0;
+    {
+        segment_tree leaderboard(num_players);
+        leaderboard.build_from(roster.data(), num_players);
+        vector<player_data> side = roster;
+
+        vector<long long> latencies;
+        latencies.reserve(num_ops);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            leaderboard.update_player_data(updates[i]);
+            side[updates[i].player_id] = updates[i];
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record("pointer", "update", num_players, num_ops, seconds_since(start), latencies);
+
+        // a scan is O(range) , keep the total work bounded on the big boards
+        int scans = max(1, min(num_ops, 200000000 / num_players));
+        latencies.clear();
+        start = bench_clock::now();
+        for (int i = 0; i < scans; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            player_data best = leaderboard.query_the_tree_by_id(lows[i], highs[i]);
+            long long total = 0;
+            int earliest = INT_MAX;
+            for (int id = lows[i]; id <= highs[i]; ++id) {
+                total += side[id].score;
+                earliest = min(earliest, side[id].finish_time);
+            }
+            latencies.push_back(nanoseconds_since(op));
+            checksum += best.player_id + total + earliest;
+        }
+        record("scan", "range_stats", num_players, scans, seconds_since(start), latencies);
+    }
+    {
+        basic_segment_tree<dashboard_aggregates> leaderboard(num_players);
+        leaderboard.build_from(roster.data(), num_players);
+
+        vector<long long> latencies;
+        latencies.reserve(num_ops);
+        bench_clock::time_point start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            leaderboard.update_player_data(updates[i]);
+            latencies.push_back(nanoseconds_since(op));
+        }
+        record("dashboard", "update", num_players, num_ops, seconds_since(start), latencies);
+
+        int scans = max(1, min(num_ops, 200000000 / num_players));
+        latencies.clear();
+        start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            range_summary<dashboard_aggregates> s = leaderboard.query_range(lows[i], highs[i]);
+            latencies.push_back(nanoseconds_since(op));
+            if (i < scans) checksum -= s.best.player_id + s.total + s.earliest;
+        }
+        record("dashboard", "range_stats", num_players, num_ops, seconds_since(start), latencies);
+
+        latencies.clear();
+        start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            range_summary<dashboard_aggregates> s = leaderboard.query_range_by_time(lows[i] % 1000, highs[i] % 1000);
+            latencies.push_back(nanoseconds_since(op));
+            checksum += s.count;
+        }
+        record("dashboard", "time_stats", num_players, num_ops, seconds_since(start), latencies);
+
+        // the frozen form answers from its sparse_table and its own heap of aggregates
+        leaderboard.freeze();
+        latencies.clear();
+        start = bench_clock::now();
+        for (int i = 0; i < num_ops; ++i) {
+            bench_clock::time_point op = bench_clock::now();
+            range_summary<dashboard_aggregates> s = leaderboard.query_range(lows[i], highs[i]);
+            latencies.push_back(nanoseconds_since(op));
+            checksum += s.count;
+        }
+        record("frozen", "range_stats", num_players, num_ops, seconds_since(start), latencies);
+    }
+    // the scan and query_range terms cancel , what is left counts the players of the time ranges and the frozen ranges
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Compare Suite =================
+// the ranking compare on its own , one implicit heap built bottom up and then answering ID ranges : player_data
+// nodes combined by best_player , against ranking_key nodes packed once when the leaves are written and combined
+// by max , as flat_segment_tree stores them
+template <class Node>
+void bench_compare_form(const string &backend, const vector<player_data> &roster, const vector<int> &lows,
+                        const vector<int> &highs, Node (*pack)(const player_data &), Node (*best)(const Node &, const Node &),
+                        player_data (*unpack)(const Node &), long long &checksum) {
+    int num_players = (int)roster.size(), num_ops = (int)lows.size();
+    int capacity = 1;
+    while (capacity < num_players) capacity <<= 1;
+    vector<Node> nodes(2 * capacity, pack(player_data()));
+
+    bench_clock::time_point start = bench_clock::now();
+    for (int i = 0; i < num_players; ++i) nodes[capacity + i] = pack(roster[i]);
+    for (int i = capacity - 1; i >= 1; --i) nodes[i] = best(nodes[2 * i], nodes[2 * i + 1]);
+    record(backend, "build", num_players, capacity - 1, seconds_since(start), vector<long long>());
+
+    start = bench_clock::now();
+    for (int i = 0; i < num_ops; ++i) {
+        Node found = pack(player_data());
+        for (int l = lows[i] + capacity, r = highs[i] + capacity + 1; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) found = best(found, nodes[l++]);
+            if (r & 1) found = best(found, nodes[--r]);
+        }
+        checksum += unpack(found).player_id;
+    }
+    record(backend, "by_id", num_players, num_ops, seconds_since(start), vector<long long>());
+}
+
+player_data same_player(const player_data &p) { return p; }
+player_data best_fields(const player_data &a, const player_data &b) { return player_data::best_player(a, b); }
+ranking_key best_key(const ranking_key &a, const ranking_key &b) { return max(a, b); }
+player_data unpack_key(const ranking_key &key) { return unpack_player(key); }
+
+void bench_compare(int num_players, int num_ops) {
+    srand(67);
+    vector<player_data> roster(num_players);
+    for (int i = 0; i < num_players; ++i) roster[i] = player_data(rand() % 1000, i, rand() % 1000);
+    vector<int> lows(num_ops), highs(num_ops);
+    for (int i = 0; i < num_ops; ++i) {
+        lows[i] = rand() % num_players;
+        highs[i] = rand() % num_players;
+        if (lows[i] > highs[i]) swap(lows[i], highs[i]);
+    }
+
+    long long checksum = 0;
+    bench_compare_form<player_data>("fields", roster, lows, highs, same_player, best_fields, same_player, checksum);
+    bench_compare_form<ranking_key>("stored_key", roster, lows, highs, pack_player, best_key, unpack_key, checksum);
+    // both forms rank the same , so this is twice the checksum of either
+    cout << "checksum: " << checksum << endl;
+}
+
+// ================= Main =================
+// build: g++ -O2 -std=c++11 -pthread benchmark.cpp -o benchmark
+// usage: benchmark [--suite core|cold_start|batch|concurrent|sharded|query_batch|journal|ingest|id_time|sliding|freeze|range_add|growth|churn|external|aggregates|compare|all] [--ops N] [--golden] [--out FILE] [num_players ...]
+//   default : core suite , 10^3 ... 10^7 players , 100000 ops , results in benchmark_results.csv
+//   --golden also runs golden_model on boards up to 10^5 players , its queries are O(n)
+int main(int argc, char **argv) {
+    string suite = "core";
+    string out = "benchmark_results.csv";
+    int num_ops = 100000;
+    bool golden = false;
+    vector<int> sizes;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--suite") && i + 1 < argc) suite = argv[++i];
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) out = argv[++i];
+        else if (!strcmp(argv[i], "--ops") && i + 1 < argc) num_ops = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--golden")) golden = true;
+        else sizes.push_back(atoi(argv[i]));
+    }
+    if (sizes.empty()) {
+        for (int n = 1000; n <= 10000000; n *= 10) sizes.push_back(n);
+    }
+    bool all = suite == "all";
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        cout << "\n=== " << sizes[i] << " players ===" << endl;
+        if (all || suite == "core") {
+            bench_core<segment_tree>("pointer", sizes[i], num_ops);
+            bench_core<flat_segment_tree>("flat", sizes[i], num_ops);
+            bench_index_share(sizes[i], num_ops);
+            if (golden && sizes[i] <= 100000) {
+                bench_core<golden_backend>("golden", sizes[i], min(num_ops, 2000));
+            }
+        }
+        if (all || suite == "cold_start") {
+            bench_cold_start<segment_tree>("pointer", sizes[i]);
+            bench_cold_start<flat_segment_tree>("flat", sizes[i]);
+            bench_snapshot(sizes[i], out + ".snapshot");
+        }
+        if (all || suite == "batch") {
+            bench_batch_updates<segment_tree>("pointer", sizes[i], 5000, 20);
+            bench_batch_updates<flat_segment_tree>("flat", sizes[i], 5000, 20);
+        }
+        if (all || suite == "concurrent") {
+            bench_concurrent_reads(sizes[i], 10000, 1.0);
+        }
+        if (all || suite == "sharded") {
+            bench_sharded(sizes[i], num_ops);
+        }
+        if (all || suite == "query_batch") {
+            bench_query_batch(sizes[i], num_ops);
+        }
+        if (all || suite == "journal") {
+            bench_journal(sizes[i], num_ops, out);
+        }
+        if (all || suite == "ingest") {
+            bench_ingest(sizes[i], out);
+        }
+        if (all || suite == "id_time") {
+            bench_id_time<segment_tree>("pointer", sizes[i], num_ops);
+            bench_id_time<flat_segment_tree>("flat", sizes[i], num_ops);
+        }
+        if (all || suite == "sliding") {
+            bench_sliding_window(sizes[i], 3600);
+        }
+        if (all || suite == "freeze") {
+            bench_freeze(sizes[i], num_ops);
+        }
+        if (all || suite == "range_add") {
+            bench_range_add(sizes[i], num_ops);
+        }
+        if (all || suite == "growth") {
+            bench_growth(sizes[i]);
+        }
+        if (all || suite == "churn") {
+            bench_churn(sizes[i], num_ops);
+        }
+        if (all || suite == "external") {
+            bench_external_ids(sizes[i], num_ops);
+        }
+        if (all || suite == "aggregates") {
+            bench_aggregates(sizes[i], num_ops);
+        }
+        if (all || suite == "compare") {
+            bench_compare(sizes[i], num_ops);
+        }
+    }
+
+    write_csv(out);
+    cout << "\nresults written to " << out << endl;
+    return 0;
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include "project.cpp"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <utility>
+
+// epoch based reclamation for one writer and any number of readers
+// a reader announces the epoch it started in , the writer frees what it retired in epoch R only when
+// every reader still inside announced an epoch >= R , such readers loaded the root after the swap
+class epoch_reclaimer {
+
+private:
+
+static const int slot_count = 128;
+static const unsigned long long idle = ~0ULL;
+
+atomic<unsigned long long> global_epoch ;
+atomic<unsigned long long> slots[slot_count] ;
+
+public:
+
+epoch_reclaimer() : global_epoch(1)
+{
+    for(int i = 0; i < slot_count; i++) {slots[i].store(idle);}
+}
+
+// claims a free slot , starting from one picked by the thread id so threads rarely collide
+int enter(){
+    unsigned long long epoch = global_epoch.load();
+    int i = (int)(hash<thread::id>()(this_thread::get_id()) % slot_count);
+
+    while(true){
+        unsigned long long expected = idle;
+        if(slots[i].compare_exchange_strong(expected,epoch)) {return i;}
+        i = (i + 1) % slot_count;
+    }
+}
+
+void leave(int slot){
+    slots[slot].store(idle);
+}
+
+// moves to the next epoch , returns the epoch of everything retired by the swap that just happened
+unsigned long long advance(){
+    return global_epoch.fetch_add(1) + 1;
+}
+
+// smallest epoch announced by a reader that is still inside , idle if there is none
+unsigned long long oldest_reader(){
+    unsigned long long oldest = idle;
+    for(int i = 0; i < slot_count; i++){
+        unsigned long long e = slots[i].load();
+        if(e < oldest) {oldest = e;}
+    }
+    return oldest;
+}
+
+};
+
+// leaderboard for one writer thread and any number of lock free reader threads
+// the writer builds every new version by path copying and publishes it with one atomic root swap ,
+// readers never wait and never see a half applied update
+class concurrent_leaderboard {
+
+private:
+
+// nodes unlinked by one published update , freed once no reader can still reach them
+struct garbage {
+    unsigned long long epoch ;
+    leaderboard_version* version ;
+    vector<tree_node*> tree_nodes ;
+    vector<index_node*> index_nodes ;
+};
+
+int max_num_of_players;
+unsigned seed ;
+atomic<leaderboard_version*> current ;
+epoch_reclaimer epochs ;
+deque<garbage> retired ; // writer only , ordered by epoch
+
+unsigned next_priority(){
+    // xorshift , same generator as ordered_index
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+void publish(leaderboard_version* next, garbage &g){
+
+    g.version = current.load();
+    current.store(next);
+    g.epoch = epochs.advance();
+    retired.push_back(move(g));
+
+    reclaim();
+}
+
+void free_oldest_garbage(){
+    garbage &g = retired.front();
+    for(size_t i = 0; i < g.tree_nodes.size(); i++) {delete g.tree_nodes[i];}
+    for(size_t i = 0; i < g.index_nodes.size(); i++) {delete g.index_nodes[i];}
+    delete g.version;
+    retired.pop_front();
+}
+
+void reclaim(){
+    unsigned long long oldest = epochs.oldest_reader();
+    while(!retired.empty() && retired.front().epoch <= oldest) {free_oldest_garbage();}
+}
+
+static void destroy(tree_node* node){
+    if(!node) {return;}
+    destroy(node->left_ptr);
+    destroy(node->right_ptr);
+    delete node;
+}
+
+static void destroy(index_node* node){
+    if(!node) {return;}
+    destroy(node->left_ptr);
+    destroy(node->right_ptr);
+    delete node;
+}
+
+public:
+
+concurrent_leaderboard(int size) :
+max_num_of_players(size),seed(2463534242u)
+{
+    leaderboard_version* empty = new leaderboard_version();
+    empty->id_root = 0;
+    empty->time_root = 0;
+    empty->reached_index = -1;
+    current.store(empty);
+}
+
+~concurrent_leaderboard(){
+    // no reader may be inside any more , so every retired batch can go
+    while(!retired.empty()) {free_oldest_garbage();}
+    leaderboard_version* last = current.load();
+    destroy(last->id_root);
+    destroy(last->time_root);
+    delete last;
+}
+
+concurrent_leaderboard(const concurrent_leaderboard &) = delete;
+concurrent_leaderboard& operator=(const concurrent_leaderboard &) = delete;
+
+// writer only
+void insert_into_tree(player_data p){
+
+    leaderboard_version* old = current.load();
+    if(old->reached_index + 1 >= max_num_of_players){
+        cerr<<"Leaderboard is full"<<endl;
+        return;
+    }
+
+    player_data p1(p.score,old->reached_index + 1,p.finish_time);
+    garbage g;
+    leaderboard_version* next = new leaderboard_version();
+    next->reached_index = p1.player_id;
+    next->id_root = path_copy_tree :: set_leaf(old->id_root,0,max_num_of_players-1,p1.player_id,p1,g.tree_nodes);
+    next->time_root = time_index :: insert_copy(old->time_root,new index_node(p1,next_priority()),g.index_nodes);
+    publish(next,g);
+}
+
+// writer only
+bool update_player_data(player_data new_player_data){
+
+    leaderboard_version* old = current.load();
+    if(new_player_data.player_id < 0 || new_player_data.player_id > old->reached_index){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    player_data p1(new_player_data.score,new_player_data.player_id,new_player_data.finish_time);
+    player_data before = path_copy_tree :: query(old->id_root,0,max_num_of_players-1,p1.player_id,p1.player_id);
+
+    garbage g;
+    leaderboard_version* next = new leaderboard_version();
+    next->reached_index = old->reached_index;
+    next->id_root = path_copy_tree :: set_leaf(old->id_root,0,max_num_of_players-1,p1.player_id,p1,g.tree_nodes);
+    index_node* time_root = time_index :: erase_copy(old->time_root,before,g.index_nodes);
+    next->time_root = time_index :: insert_copy(time_root,new index_node(p1,next_priority()),g.index_nodes);
+    publish(next,g);
+    return true;
+}
+
+// safe from any thread , lock free
+player_data query_the_tree_by_id(int begin_id, int end_id){
+
+    int slot = epochs.enter();
+    leaderboard_version* v = current.load();
+    player_data best ;
+
+    if(begin_id < 0 || end_id > v->reached_index){
+        cerr<<"Invalid ID "<<endl;
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+    }
+    else {
+        best = path_copy_tree :: query(v->id_root,0,max_num_of_players-1,begin_id,end_id);
+    }
+
+    epochs.leave(slot);
+    return best;
+}
+
+// safe from any thread , lock free
+player_data query_the_tree_by_time(int start_time, int finish_time){
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+
+    int slot = epochs.enter();
+    player_data best = time_index :: query_root(current.load()->time_root,start_time,finish_time);
+    epochs.leave(slot);
+    return best;
+}
+
+};
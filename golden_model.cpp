@@ -0,0 +1,152 @@
+#pragma once
+#include "project.cpp"
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+// ================= Golden Model =================
+class golden_model {
+public:
+    void add_player(const player_data &p) { players.push_back(p); }
+
+    player_data query_by_time(int start, int end) {
+        player_data best;
+        for (const auto &p : players) {
+            if (p.finish_time >= start && p.finish_time <= end) {
+                best = better_of(best, p);
+            }
+        }
+        return best;
+    }
+
+    player_data query_by_id(int start_id, int end_id) {
+        player_data best;
+        for (const auto &p : players) {
+            if (p.player_id >= start_id && p.player_id <= end_id) {
+                best = better_of(best, p);
+            }
+        }
+        return best;
+    }
+
+    player_data query_by_id_and_time(int start_id, int end_id, int start, int end) {
+        player_data best;
+        for (const auto &p : players) {
+            if (p.player_id >= start_id && p.player_id <= end_id &&
+                p.finish_time >= start && p.finish_time <= end) {
+                best = better_of(best, p);
+            }
+        }
+        return best;
+    }
+
+    range_summary<dashboard_aggregates> summary_by_id(int start_id, int end_id) {
+        range_summary<dashboard_aggregates> s;
+        for (const auto &p : players) {
+            if (p.player_id >= start_id && p.player_id <= end_id) add_to_summary(s, p);
+        }
+        return s;
+    }
+
+    range_summary<dashboard_aggregates> summary_by_time(int start, int end) {
+        range_summary<dashboard_aggregates> s;
+        for (const auto &p : players) {
+            if (p.finish_time >= start && p.finish_time <= end) add_to_summary(s, p);
+        }
+        return s;
+    }
+
+    vector<player_data> top_k_by_time(int start, int end, int k) {
+        vector<player_data> found;
+        for (const auto &p : players) {
+            if (p.player_id != -1 && p.finish_time >= start && p.finish_time <= end) {
+                found.push_back(p);
+            }
+        }
+        return best_k(found, k);
+    }
+
+    vector<player_data> top_k_by_id(int start_id, int end_id, int k) {
+        vector<player_data> found;
+        for (const auto &p : players) {
+            if (p.player_id != -1 && p.player_id >= start_id && p.player_id <= end_id) {
+                found.push_back(p);
+            }
+        }
+        return best_k(found, k);
+    }
+
+    int rank_of(int player_id) {
+        for (const auto &p : players) {
+            if (p.player_id != player_id) continue;
+            int rank = 1;
+            for (const auto &q : players) {
+                if (ranks_above(q, p)) rank++;
+            }
+            return rank;
+        }
+        return -1;
+    }
+
+    player_data player_at(int rank) {
+        vector<player_data> order = players;
+        sort(order.begin(), order.end(), ranks_above);
+        if (rank < 1 || rank > (int)order.size()) return player_data();
+        return order[rank - 1];
+    }
+
+    bool update_player(const player_data &new_data) {
+        for (auto &p : players) {
+            if (p.player_id == new_data.player_id) {
+                p = new_data;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool remove_player(int player_id) {
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (players[i].player_id == player_id) {
+                players.erase(players.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void add_score_range(int start_id, int end_id, int delta) {
+        for (auto &p : players) {
+            if (p.player_id >= start_id && p.player_id <= end_id) p.score += delta;
+        }
+    }
+
+private:
+    vector<player_data> players;
+
+    // the ranking spelled out here instead of borrowed from player_data , so a broken tree ordering shows up :
+    // higher score , then earlier finish_time , then larger player_id , the empty player (player_id -1) last
+    static bool ranks_above(const player_data &a, const player_data &b) {
+        if ((a.player_id == -1) != (b.player_id == -1)) return b.player_id == -1;
+        if (a.score != b.score) return a.score > b.score;
+        if (a.finish_time != b.finish_time) return a.finish_time < b.finish_time;
+        return a.player_id > b.player_id;
+    }
+
+    static player_data better_of(const player_data &a, const player_data &b) {
+        return ranks_above(b, a) ? b : a;
+    }
+
+    static void add_to_summary(range_summary<dashboard_aggregates> &s, const player_data &p) {
+        s.best = better_of(s.best, p);
+        s.count++;
+        s.total += p.score;
+        s.earliest = min(s.earliest, p.finish_time);
+    }
+
+    static vector<player_data> best_k(vector<player_data> found, int k) {
+        sort(found.begin(), found.end(), ranks_above);
+        if ((int)found.size() > k) found.resize(k);
+        return found;
+    }
+};
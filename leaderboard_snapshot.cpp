@@ -0,0 +1,233 @@
+#pragma once
+#include "project.cpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+// binary snapshot of a segment_tree , written once and opened read only through mmap
+//
+// layout , host byte order , every section starts on a 4 byte boundary :
+//   snapshot_header
+//   id_nodes   [2 * capacity]  implicit heap over the players in ID order , leaves start at capacity
+//   by_time    [count]         the same players sorted by finish_time
+//   time_nodes [2 * capacity]  implicit heap over by_time
+// capacity is the player count rounded up to a power of two , so the file grows with the players , not the board size
+// both heaps keep the precomputed winner of every internal node , a query reads O(log n) nodes and only the pages
+// holding them are ever faulted in
+
+const char snapshot_magic[8] = {'L','B','S','N','A','P','\0','\0'};
+const int snapshot_format = 2;
+static_assert(sizeof(player_data) == 3 * sizeof(int), "snapshot stores player_data as raw records");
+
+struct snapshot_header {
+    char magic[8];
+    int format;
+    int max_num_of_players;
+    int reached_index;
+    int capacity;
+    long long journal_sequence; // last journal record the snapshot holds , 0 outside a journaled_leaderboard
+};
+
+// implicit heap over leaves , internal nodes filled from the bottom
+static vector<player_data> snapshot_heap(const vector<player_data> &leaves, int capacity){
+    vector<player_data> nodes(2*capacity);
+    for(size_t i = 0; i < leaves.size(); i++) {nodes[capacity + i] = leaves[i];}
+    for(int i = capacity - 1; i >= 1; i--){
+        nodes[i] = player_data :: best_player(nodes[2*i],nodes[2*i+1]);
+    }
+    return nodes;
+}
+
+// best player of the leaves [first , last] of an implicit heap , bottom up
+static player_data snapshot_range_best(const player_data* nodes, int capacity, int first, int last){
+    player_data best ;
+    for(int l = first + capacity, r = last + capacity + 1; l < r; l >>= 1, r >>= 1){
+        if(l & 1) {best = player_data :: best_player(best,nodes[l++]);}
+        if(r & 1) {best = player_data :: best_player(best,nodes[--r]);}
+    }
+    return best;
+}
+
+struct finish_time_less {
+    bool operator()(const player_data &a, const player_data &b) const {
+        return a.finish_time < b.finish_time;
+    }
+};
+
+// writes the complete state of tree to path , false when the file cannot be written
+bool save_snapshot(const segment_tree &tree, const string &path, long long journal_sequence = 0){
+
+    vector<player_data> players = tree.players();
+    int count = (int)players.size();
+    int capacity = 1;
+    while(capacity < count) {capacity <<= 1;}
+
+    vector<player_data> by_time = players;
+    stable_sort(by_time.begin(),by_time.end(),finish_time_less());
+
+    vector<player_data> id_nodes = snapshot_heap(players,capacity);
+    vector<player_data> time_nodes = snapshot_heap(by_time,capacity);
+
+    snapshot_header header;
+    memcpy(header.magic,snapshot_magic,sizeof(header.magic));
+    header.format = snapshot_format;
+    header.max_num_of_players = tree.size();
+    header.reached_index = tree.last_index();
+    header.capacity = capacity;
+    header.journal_sequence = journal_sequence;
+
+    ofstream out(path.c_str(),ios::binary | ios::trunc);
+    out.write((const char*)&header,sizeof(header));
+    out.write((const char*)id_nodes.data(),id_nodes.size() * sizeof(player_data));
+    out.write((const char*)by_time.data(),by_time.size() * sizeof(player_data));
+    out.write((const char*)time_nodes.data(),time_nodes.size() * sizeof(player_data));
+    out.close();
+
+    if(!out){
+        cerr<<"Cannot write snapshot "<<path<<endl;
+        return false;
+    }
+    return true;
+}
+
+// read only leaderboard answering straight from a mapped snapshot , opening costs one mmap whatever the board size
+class mapped_leaderboard {
+
+private:
+
+void* base ;
+size_t length ;
+const snapshot_header* header ;
+const player_data* id_nodes ;
+const player_data* by_time ;
+const player_data* time_nodes ;
+
+int count() const {
+    return header ? header->reached_index + 1 : 0;
+}
+
+void close_mapping(){
+    if(base) {munmap(base,length);}
+    base = 0;
+    length = 0;
+    header = 0;
+    id_nodes = by_time = time_nodes = 0;
+}
+
+public:
+
+mapped_leaderboard(const string &path) :
+base(0),length(0),header(0),id_nodes(0),by_time(0),time_nodes(0)
+{
+    int fd = open(path.c_str(),O_RDONLY);
+    if(fd < 0){
+        cerr<<"Cannot open snapshot "<<path<<endl;
+        return;
+    }
+
+    struct stat info;
+    if(fstat(fd,&info) == 0 && info.st_size >= (off_t)sizeof(snapshot_header)){
+        length = (size_t)info.st_size;
+        base = mmap(0,length,PROT_READ,MAP_SHARED,fd,0);
+        if(base == MAP_FAILED) {base = 0;}
+    }
+    ::close(fd); // the mapping keeps the file alive
+
+    if(!base){
+        length = 0;
+        cerr<<"Invalid Snapshot"<<endl;
+        return;
+    }
+
+    // queries touch a handful of scattered nodes , read ahead would only page in what nobody asked for
+    madvise(base,length,MADV_RANDOM);
+
+    header = (const snapshot_header*)base;
+    long long capacity = header->capacity;
+    long long players = (long long)header->reached_index + 1;
+    size_t expected = sizeof(snapshot_header) + (size_t)(4*capacity + players) * sizeof(player_data);
+    if(memcmp(header->magic,snapshot_magic,sizeof(header->magic)) != 0 || header->format != snapshot_format ||
+       capacity < 1 || players < 0 || players > capacity || players > header->max_num_of_players ||
+       expected != length){
+        cerr<<"Invalid Snapshot"<<endl;
+        close_mapping();
+        return;
+    }
+
+    id_nodes = (const player_data*)(header + 1);
+    by_time = id_nodes + 2*capacity;
+    time_nodes = by_time + players;
+}
+
+~mapped_leaderboard(){
+    close_mapping();
+}
+
+mapped_leaderboard(const mapped_leaderboard &) = delete;
+mapped_leaderboard& operator=(const mapped_leaderboard &) = delete;
+
+bool is_open() const {
+    return header != 0;
+}
+
+int size() const {
+    return header ? header->max_num_of_players : 0;
+}
+
+int last_index() const {
+    return count() - 1;
+}
+
+long long journal_sequence() const {
+    return header ? header->journal_sequence : 0;
+}
+
+player_data query_the_tree_by_id(int begin_id, int end_id){
+
+    if(begin_id < 0 || end_id > last_index()){
+
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+    return snapshot_range_best(id_nodes,header->capacity,begin_id,end_id);
+}
+
+// the players of a time range are one contiguous run of by_time , found by two binary searches
+player_data query_the_tree_by_time(int start_time, int finish_time){
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+    if(!header) {return player_data();}
+
+    player_data low(0,0,start_time), high(0,0,finish_time);
+    int first = (int)(lower_bound(by_time,by_time + count(),low,finish_time_less()) - by_time);
+    int last = (int)(upper_bound(by_time,by_time + count(),high,finish_time_less()) - by_time) - 1;
+    if(first > last) {return player_data();}
+    return snapshot_range_best(time_nodes,header->capacity,first,last);
+}
+
+// rebuilds a writable board from the snapshot , tree must be empty , it grows to fit the players
+// the leaves are handed to build_from straight out of the mapping , so this is one O(n) pass
+// removed slots (stored as the empty player) are removed again and go back on the free list
+void restore_into(segment_tree &tree){
+    if(!header) {return;}
+    const player_data* leaves = id_nodes + header->capacity;
+    tree.build_from(leaves,count());
+    for(int id = 0; id < count(); id++){
+        if(leaves[id].player_id == -1) {tree.remove_player(id);}
+    }
+}
+
+};
@@ -1,7 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <climits>
 #include <iostream>
+#include <new>
+#include <queue>
+#include <type_traits>
+#include <vector>
 
 using namespace std;
 
+// optional hot path counters , compiled in with -DLEADERBOARD_STATS , without it every hook below is empty
+// a segment_tree operation makes its own op_stats record active for the calling thread , so the shared code
+// (best_player , the node pool , the indexes) counts into whichever operation is running
+// the record is private to the thread and added to the tree once when the operation ends , so readers on
+// several threads (query_batch , concurrent readers) count without racing
+#ifdef LEADERBOARD_STATS
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+enum op_type { op_insert, op_update, op_batch_update, op_build, op_query_by_id, op_query_by_time, op_top_k, op_rank, op_query_2d, op_range_add, op_remove, op_type_count };
+
+static const char* const op_type_names[op_type_count] = {
+    "insert", "update", "batch_update", "build", "query_by_id", "query_by_time", "top_k", "rank", "query_2d", "range_add", "remove"
+};
+
+static const int latency_bucket_count = 40;
+
+struct op_stats {
+    long long calls ;
+    long long nodes_visited ;
+    long long nodes_allocated ;
+    long long comparisons ;                          // best_player / ranks_higher calls
+    long long latency_buckets[latency_bucket_count]; // bucket i counts calls that took [2^i , 2^(i+1)) ns
+};
+
+// counters of one tree , a plain copyable value so snapshots are just copies
+struct tree_stats {
+    op_stats ops[op_type_count];
+
+    tree_stats() {reset();}
+
+    void reset(){
+        for(int i = 0; i < op_type_count; i++) {ops[i] = op_stats();}
+    }
+
+    // one CSV row per operation type : counters , then the histogram buckets
+    void export_csv(ostream &out) const {
+        out << "operation,calls,nodes_visited,nodes_allocated,comparisons";
+        for(int b = 0; b < latency_bucket_count; b++) {out << ",lat_2^" << b << "ns";}
+        out << "\n";
+
+        for(int i = 0; i < op_type_count; i++){
+            const op_stats &o = ops[i];
+            out << op_type_names[i] << ',' << o.calls << ',' << o.nodes_visited << ',' << o.nodes_allocated << ',' << o.comparisons;
+            for(int b = 0; b < latency_bucket_count; b++) {out << ',' << o.latency_buckets[b];}
+            out << "\n";
+        }
+    }
+};
+
+// the counters of one operation type as the tree keeps them , relaxed atomics : every finished operation adds its
+// record in one go , a snapshot taken meanwhile may see some operations of a burst and not others
+struct shared_op_stats {
+    atomic<long long> calls ;
+    atomic<long long> nodes_visited ;
+    atomic<long long> nodes_allocated ;
+    atomic<long long> comparisons ;
+    atomic<long long> latency_buckets[latency_bucket_count];
+
+    shared_op_stats() {reset();}
+
+    void reset(){
+        calls.store(0,memory_order_relaxed);
+        nodes_visited.store(0,memory_order_relaxed);
+        nodes_allocated.store(0,memory_order_relaxed);
+        comparisons.store(0,memory_order_relaxed);
+        for(int b = 0; b < latency_bucket_count; b++) {latency_buckets[b].store(0,memory_order_relaxed);}
+    }
+
+    // o is the record of one finished operation , only its own latency bucket is set
+    void add(const op_stats &o, int bucket){
+        calls.fetch_add(o.calls,memory_order_relaxed);
+        nodes_visited.fetch_add(o.nodes_visited,memory_order_relaxed);
+        nodes_allocated.fetch_add(o.nodes_allocated,memory_order_relaxed);
+        comparisons.fetch_add(o.comparisons,memory_order_relaxed);
+        latency_buckets[bucket].fetch_add(1,memory_order_relaxed);
+    }
+
+    op_stats load() const {
+        op_stats o ;
+        o.calls = calls.load(memory_order_relaxed);
+        o.nodes_visited = nodes_visited.load(memory_order_relaxed);
+        o.nodes_allocated = nodes_allocated.load(memory_order_relaxed);
+        o.comparisons = comparisons.load(memory_order_relaxed);
+        for(int b = 0; b < latency_bucket_count; b++) {o.latency_buckets[b] = latency_buckets[b].load(memory_order_relaxed);}
+        return o;
+    }
+};
+
+// the counters a tree owns , written by every thread that runs one of its operations
+struct shared_tree_stats {
+    shared_op_stats ops[op_type_count];
+
+    void reset(){
+        for(int i = 0; i < op_type_count; i++) {ops[i].reset();}
+    }
+
+    tree_stats snapshot() const {
+        tree_stats t ;
+        for(int i = 0; i < op_type_count; i++) {t.ops[i] = ops[i].load();}
+        return t;
+    }
+};
+
+static thread_local op_stats* active_op_stats = 0;
+
+// makes a private record active for the lifetime of a public operation , then adds it and its latency to the tree
+class op_scope {
+
+private:
+
+op_stats* saved ;
+shared_op_stats* target ;
+op_stats counts ;
+chrono::steady_clock::time_point start ;
+
+public:
+
+op_scope(shared_tree_stats &stats, op_type op) :
+saved(active_op_stats),target(&stats.ops[op]),counts(),start(chrono::steady_clock::now())
+{
+    counts.calls = 1;
+    active_op_stats = &counts;
+}
+
+~op_scope(){
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    int bucket = 0;
+    while(bucket + 1 < latency_bucket_count && (1LL << (bucket + 1)) <= ns) {bucket++;}
+    target->add(counts,bucket);
+    active_op_stats = saved;
+}
+
+};
+
+#define LB_OP_SCOPE(op) op_scope lb_op_scope(this->stats,op)
+#define LB_VISIT() do { if(active_op_stats) {active_op_stats->nodes_visited++;} } while(0)
+#define LB_ALLOC() do { if(active_op_stats) {active_op_stats->nodes_allocated++;} } while(0)
+#define LB_COMPARE() do { if(active_op_stats) {active_op_stats->comparisons++;} } while(0)
+
+#else
+
+#define LB_OP_SCOPE(op) ((void)0)
+#define LB_VISIT() ((void)0)
+#define LB_ALLOC() ((void)0)
+#define LB_COMPARE() ((void)0)
+
+#endif
+
 class player_data{
 
 public : 
@@ -18,252 +176,2704 @@ public :
     score(score) , player_id(player_id) , finish_time(finish_time)
     {}
 
+    // true if a ranks above b : higher score , then earlier finish_time , then larger player_id , an empty slot
+    // (player_id -1) below every player , a real player can have any score , -1 included , range adds take
+    // scores negative
+    // fields are compared directly , packing a key on every call was slower , flat_segment_tree stores the keys
+    // instead (ranking_key)
+    static bool ranks_higher(const player_data &a, const player_data &b) {
+        LB_COMPARE();
+        if(a.player_id == -1) {return false;}
+        if(b.player_id == -1) {return true;}
+        if(a.score != b.score) {return a.score > b.score;}
+        if(a.finish_time != b.finish_time) {return a.finish_time < b.finish_time;}
+        return a.player_id > b.player_id;
+    }
+
     static player_data best_player(const player_data &a, const player_data &b) {
-        if(a.score == -1 && b.score == -1) {return player_data();} //no players
-        
-        if(a.score == -1) {return b;}
+        return ranks_higher(a,b) ? a : b;
+    }
 
-        if(b.score == -1) {return a;}
+};
 
-        if(a.score > b.score) {return a;}
-        else if (b.score > a.score) {return b;}
-        else {
+// a player packed into one 128 bit key that orders like ranks_higher : the biased score in the top 64 bits , the
+// inverted finish_time below it and the biased player_id as the tie break , the empty player is 0 , below everyone
+// the key holds all three fields , so a tree can store keys only , combine two nodes with one unsigned max and
+// unpack the answer alone
+__extension__ typedef unsigned __int128 ranking_key;
+
+inline ranking_key pack_player(const player_data &p){
+    if(p.player_id == -1) {return 0;}
+    ranking_key score = (unsigned)p.score ^ 0x80000000u;
+    ranking_key finish = ~((unsigned)p.finish_time ^ 0x80000000u);
+    return (score << 64) | (finish << 32) | ((unsigned)p.player_id ^ 0x80000000u);
+}
 
-            if(a.finish_time < b.finish_time) {return a;}
-            else if (b.finish_time < a.finish_time) {return b;}
-            else {
+inline player_data unpack_player(ranking_key key){
+    if(key == 0) {return player_data();}
+    return player_data((int)((unsigned)(key >> 64) ^ 0x80000000u),(int)((unsigned)key ^ 0x80000000u),
+                       (int)(~(unsigned)(key >> 32) ^ 0x80000000u));
+}
 
-                if(a.player_id > b.player_id) {return a;}
-                else if (b.player_id > a.player_id) {return b;}
-                // no duplication allowed in player registration for the ID
-                else {cerr<< "Error : Player is registered twice"<<endl;
-                    return a;
-                }
-            }
+// compile time combine policies for the range aggregates kept next to the best player in every node
+// a policy gives the value type , whose default value is the empty range , the value of one player (the empty
+// player counts as nothing) , how two values combine (in any order , the treaps do not walk in key order) , and
+// what a score shift of every player does
+// the nodes inherit the value , so a policy with an empty value costs no memory , and every call inlines
+struct no_aggregates {
+    struct value {};
+    static value of(const player_data &) {return value();}
+    static value combine(const value &, const value &) {return value();}
+    static void shift(value &, int) {}
+};
 
+// number of players and their total score , the mean follows from the two
+struct score_sum_aggregate {
+    struct value {
+        int count ;
+        long long total ;
 
+        value() : count(0),total(0) {}
+
+        double mean() const {
+            return count ? (double)total / count : 0;
         }
+    };
+    static value of(const player_data &p){
+        value v;
+        if(p.player_id != -1) {v.count = 1; v.total = p.score;}
+        return v;
+    }
+    static value combine(const value &a, const value &b){
+        value v;
+        v.count = a.count + b.count;
+        v.total = a.total + b.total;
+        return v;
+    }
+    static void shift(value &v, int delta){
+        v.total += (long long)delta * v.count;
+    }
+};
+
+// earliest finish_time , INT_MAX for no players
+struct earliest_finish_aggregate {
+    struct value {
+        int earliest ;
+
+        value() : earliest(INT_MAX) {}
+    };
+    static value of(const player_data &p){
+        value v;
+        if(p.player_id != -1) {v.earliest = p.finish_time;}
+        return v;
+    }
+    static value combine(const value &a, const value &b){
+        value v;
+        v.earliest = min(a.earliest,b.earliest);
+        return v;
+    }
+    static void shift(value &, int) {}
+};
+
+// two policies side by side , the members of both values are reachable directly , nest it for more
+template <class First, class Second>
+struct both_aggregates {
+    struct value : First::value, Second::value {};
 
+    static value of(const player_data &p){
+        value v;
+        static_cast<typename First::value&>(v) = First::of(p);
+        static_cast<typename Second::value&>(v) = Second::of(p);
+        return v;
+    }
+    static value combine(const value &a, const value &b){
+        value v;
+        static_cast<typename First::value&>(v) = First::combine(a,b);
+        static_cast<typename Second::value&>(v) = Second::combine(a,b);
+        return v;
+    }
+    static void shift(value &v, int delta){
+        First::shift(v,delta);
+        Second::shift(v,delta);
     }
+};
+
+// every statistic a leaderboard page shows for a range besides its best player
+typedef both_aggregates<score_sum_aggregate,earliest_finish_aggregate> dashboard_aggregates;
 
+// answer of a multi aggregate range query : the best player plus every value of the policy
+template <class Agg>
+struct range_summary : Agg::value {
+    player_data best ;
 
+    static range_summary join(const range_summary &a, const range_summary &b){
+        range_summary s;
+        s.best = player_data :: best_player(a.best,b.best);
+        static_cast<typename Agg::value&>(s) = Agg::combine(a,b);
+        return s;
+    }
 };
 
-class tree_node {
+template <class Agg>
+class basic_tree_node : public Agg::value {
 public:
     player_data p;        
     int l, r;        
-    tree_node* left_ptr;      
-    tree_node* right_ptr;     
+    int pending;          // score added to the whole subtree , p already has it , the children not yet
+    basic_tree_node* left_ptr;      
+    basic_tree_node* right_ptr;     
 
 
-    tree_node(int L, int R) 
-        : l(L), r(R) ,left_ptr(0), right_ptr(0) {
+    basic_tree_node(int L, int R) 
+        : l(L), r(R) ,pending(0),left_ptr(0), right_ptr(0) {
             p = player_data();
         }
 
-    tree_node(int L, int R, int score, int player_id, int finish_time) :
-         l(L), r(R), left_ptr(0), right_ptr(0) {
+    basic_tree_node(int L, int R, int score, int player_id, int finish_time) :
+         l(L), r(R), pending(0), left_ptr(0), right_ptr(0) {
             p = player_data(score,player_id,finish_time);
+            static_cast<typename Agg::value&>(*this) = Agg::of(p);
         }
 
 };
 
-class segment_tree {
+typedef basic_tree_node<no_aggregates> tree_node;
+
+// hands out tree nodes from large blocks instead of one new per node , every block is released with the pool
+// blocks start small and double up to 1024 nodes , so the many small indexes of id_time_index stay small too
+template <class Node>
+class basic_node_pool {
 
 private:
 
-tree_node * root_node ; 
-int max_num_of_players;
-int reached_index ; // cannot be global , due multible instances of the segment tree will make indexing wrong
+static const int first_block = 16;
+static const int largest_block = 1024;
 
-void insert_helper_function(tree_node* &node ,int left ,int right,int index,player_data data){
+vector<Node*> blocks ;
+Node* next_free ; // next unused node of the current block
+int left_in_block ;
+int block_size ;  // size of the next block create adds
+Node* released ;  // nodes given back with release , chained through left_ptr
 
-if(!node) {
-    node = new tree_node(left,right);
+void add_block(int count){
+    Node* block = static_cast<Node*>(::operator new(sizeof(Node) * count));
+    blocks.push_back(block);
+    next_free = block;
+    left_in_block = count;
 }
 
-if(left == right){
+public:
 
-    node->p = data;
-    return;
+basic_node_pool() : next_free(0), left_in_block(0), block_size(first_block), released(0)
+{}
+
+~basic_node_pool(){
+    // tree and index nodes are trivially destructible , only the raw storage has to go
+    for(size_t i = 0; i < blocks.size(); i++){
+        ::operator delete(blocks[i]);
+    }
 }
 
-int mid = (left + right) / 2 ;
+basic_node_pool(const basic_node_pool &) = delete;
+basic_node_pool& operator=(const basic_node_pool &) = delete;
 
-if (index <= mid){
+// frees every node at once , the pool starts over empty
+void clear(){
+    for(size_t i = 0; i < blocks.size(); i++){
+        ::operator delete(blocks[i]);
+    }
+    blocks.clear();
+    next_free = 0;
+    left_in_block = 0;
+    block_size = first_block;
+    released = 0;
+}
 
-    insert_helper_function(node->left_ptr,left,mid,index,data);
+// makes sure the next count nodes come from a single allocation
+void reserve(int count){
+    if(left_in_block < count) {add_block(count);}
+}
 
+// a node built from args , a released one if there is any
+template <class... Args>
+Node* create(Args... args){
+    LB_ALLOC();
+    if(released){
+        Node* node = released;
+        released = node->left_ptr;
+        return new (node) Node(args...);
+    }
+    if(left_in_block == 0){
+        add_block(block_size);
+        if(block_size < largest_block) {block_size *= 2;}
+    }
+    left_in_block--;
+    return new (next_free++) Node(args...);
 }
-else {
-    insert_helper_function(node->right_ptr,mid+1,right,index,data);
+
+// takes a node back , the next create hands it out again
+void release(Node* node){
+    node->left_ptr = released;
+    released = node;
+}
+
+};
+
+typedef basic_node_pool<tree_node> node_pool;
+
+// balanced search tree (treap) node shared by the secondary indexes , every node keeps the best player and
+// the number of players of its subtree , and the aggregates of Agg over the subtree
+template <class Agg>
+class basic_index_node : public Agg::value {
+public:
+    player_data p;          // player stored in this node
+    player_data best;       // best player of the whole subtree
+    int size;               // number of players in the subtree
+    unsigned priority;
+    basic_index_node* left_ptr;
+    basic_index_node* right_ptr;
+
+    basic_index_node(player_data data, unsigned prio) :
+        Agg::value(Agg::of(data)), p(data), best(data), size(1), priority(prio), left_ptr(0), right_ptr(0)
+    {}
+};
+
+typedef basic_index_node<no_aggregates> index_node;
+
+// key of the finish_time index : (finish_time , player_id)
+struct finish_time_order {
+    bool operator()(const player_data &a, const player_data &b) const {
+        if(a.finish_time != b.finish_time) {return a.finish_time < b.finish_time;}
+        return a.player_id < b.player_id;
+    }
+};
+
+// key of the rank index : the best_player ordering , best first , empty slots (player_id -1) after every player
+struct rank_order {
+    bool operator()(const player_data &a, const player_data &b) const {
+        return player_data :: ranks_higher(a,b);
+    }
+};
+
+// players kept sorted by Order in a treap , O(log n) insert / erase / rank / select
+// every node also keeps the Agg aggregates of its subtree , the nodes come from the index's own pool , so an insert
+// does not call new and an erase hands its node to the next insert
+template <class Order, class Agg = no_aggregates>
+class ordered_index {
+
+protected:
+
+typedef basic_index_node<Agg> index_node;
+typedef typename Agg::value aggregate;
+
+index_node* root_node;
+unsigned seed;
+basic_node_pool<index_node> pool ; // owns every node of this index , not the path copies of the static helpers
+
+static bool key_less(const player_data &a, const player_data &b){
+    return Order()(a,b);
 }
 
-player_data p1 ;
-player_data p2 ;
+unsigned next_priority(){
+    // xorshift , fixed seed so the shape of the tree is reproducible
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
 
-if(node->left_ptr){
-    p1 = node->left_ptr->p;
+static int size_of(index_node* node){
+    return node ? node->size : 0;
 }
-if(node->right_ptr){
-    p2 = node->right_ptr->p;
+
+static void pull(index_node* node){
+    player_data left_best ;
+    player_data right_best ;
+    if(node->left_ptr) {left_best = node->left_ptr->best;}
+    if(node->right_ptr) {right_best = node->right_ptr->best;}
+    node->best = player_data :: best_player(player_data :: best_player(left_best,node->p),right_best);
+    node->size = 1 + size_of(node->left_ptr) + size_of(node->right_ptr);
+
+    aggregate &value = *node;
+    value = Agg::of(node->p);
+    if(node->left_ptr) {value = Agg::combine(*node->left_ptr,value);}
+    if(node->right_ptr) {value = Agg::combine(value,*node->right_ptr);}
 }
-node->p = player_data:: best_player(p1,p2);
+
+// l gets the keys smaller than key , r gets the rest
+static void split(index_node* node, const player_data &key, index_node* &l, index_node* &r){
+    if(!node) {l = r = 0; return;}
+    LB_VISIT();
+
+    if(key_less(node->p,key)){
+        split(node->right_ptr,key,node->right_ptr,r);
+        l = node;
+    }
+    else {
+        split(node->left_ptr,key,l,node->left_ptr);
+        r = node;
+    }
+    pull(node);
 }
 
+static index_node* merge(index_node* l, index_node* r){
+    if(!l) {return r;}
+    if(!r) {return l;}
+    LB_VISIT();
 
-player_data query_helper_function(tree_node* &node,int start_interval,int end_interval){
+    if(l->priority > r->priority){
+        l->right_ptr = merge(l->right_ptr,r);
+        pull(l);
+        return l;
+    }
+    r->left_ptr = merge(l,r->left_ptr);
+    pull(r);
+    return r;
+}
 
-    if(!node){
-        return player_data();
+// unlinks the node holding key and returns it , 0 if there is none
+static index_node* detach(index_node* &node, const player_data &key){
+    if(!node) {return 0;}
+    LB_VISIT();
+
+    if(!key_less(node->p,key) && !key_less(key,node->p)){
+        index_node* found = node;
+        node = merge(node->left_ptr,node->right_ptr);
+        found->left_ptr = found->right_ptr = 0;
+        return found;
     }
 
-    if(node->left_ptr == 0 && node->right_ptr == 0){
+    index_node* found = key_less(key,node->p) ? detach(node->left_ptr,key) : detach(node->right_ptr,key);
+    if(found) {pull(node);}
+    return found;
+}
 
-        if(node->p.finish_time>=start_interval && node->p.finish_time<=end_interval){
+void insert_node(index_node* fresh){
+    index_node* l ;
+    index_node* r ;
+    split(root_node,fresh->p,l,r);
+    root_node = merge(merge(l,fresh),r);
+}
 
-            return node->p;
-        }
+// cartesian tree over players already sorted by Order , O(n)
+index_node* build_sorted(const vector<player_data> &players){
 
-        else {return player_data();}
+    // right spine of the tree built so far , priorities decrease from bottom to top
+    vector<index_node*> spine;
+    pool.reserve((int)players.size());
+    for(size_t i = 0; i < players.size(); i++){
+        index_node* node = pool.create(players[i],next_priority());
+        index_node* last = 0;
 
+        while(!spine.empty() && spine.back()->priority < node->priority){
+            last = spine.back();
+            spine.pop_back();
+        }
+        node->left_ptr = last;
+        if(!spine.empty()) {spine.back()->right_ptr = node;}
+        spine.push_back(node);
     }
 
-    player_data left =  query_helper_function(node->left_ptr,start_interval,end_interval);
+    index_node* root = spine.empty() ? 0 : spine[0];
+    pull_all(root);
+    return root;
+}
 
-    player_data right = query_helper_function(node->right_ptr,start_interval,end_interval);
+// union of two treaps : the higher priority root stays on top and splits the other tree around its key
+static index_node* unite(index_node* a, index_node* b){
+    if(!a) {return b;}
+    if(!b) {return a;}
+    LB_VISIT();
+
+    if(a->priority < b->priority) {swap(a,b);}
+    index_node* l ;
+    index_node* r ;
+    split(b,a->p,l,r);
+    a->left_ptr = unite(a->left_ptr,l);
+    a->right_ptr = unite(a->right_ptr,r);
+    pull(a);
+    return a;
+}
 
-    return player_data :: best_player(left,right);
+static void pull_all(index_node* node){
+    if(!node) {return;}
+    pull_all(node->left_ptr);
+    pull_all(node->right_ptr);
+    pull(node);
 }
 
+public:
 
+ordered_index() : root_node(0), seed(2463534242u)
+{}
 
+~ordered_index(){
+    // the pool frees every node
+}
 
+ordered_index(const ordered_index &) = delete;
+ordered_index& operator=(const ordered_index &) = delete;
 
+int size(){
+    return size_of(root_node);
+}
 
-bool update(tree_node* &node ,int left,int right ,player_data new_data) {
+void insert(player_data p){
+    insert_node(pool.create(p,next_priority()));
+}
 
-    if(!node) {
-        return false ;
-    }
+bool erase(player_data p){
+    index_node* found = detach(root_node,p);
+    if(found) {pool.release(found);}
+    return found != 0;
+}
 
-    if(left == right && left == new_data.player_id){
+// drops every player
+void clear(){
+    pool.clear();
+    root_node = 0;
+}
 
-        node->p = new_data;
-        return true ;
+// moves a player to its new key , reusing its node
+void replace(player_data old_data, player_data new_data){
+    index_node* found = detach(root_node,old_data);
+    if(!found) {found = pool.create(new_data,next_priority());}
+    found->p = new_data;
+    found->best = new_data;
+    found->size = 1;
+    static_cast<aggregate&>(*found) = Agg::of(new_data);
+    insert_node(found);
+}
+
+// builds the index of an empty tree at once : sort , then a linear cartesian tree build over the sorted players
+// a non empty index gets the new players built the same way and united with the old tree , which beats one
+// insert per player as soon as the batch is more than a handful
+void build_from(vector<player_data> players){
+    sort(players.begin(),players.end(),Order());
+    root_node = unite(root_node,build_sorted(players));
+}
+
+// path copying versions of insert and erase : the tree below node is never modified , every node on the
+// changed path is copied and the originals are reported in replaced , the new root is returned
+static index_node* insert_copy(index_node* node, index_node* fresh, vector<index_node*> &replaced, vector<index_node*>* created = 0){
+    if(!node) {return fresh;}
+
+    index_node* copy = new index_node(*node);
+    replaced.push_back(node);
+    if(created) {created->push_back(copy);}
+
+    if(key_less(fresh->p,node->p)){
+        copy->left_ptr = insert_copy(node->left_ptr,fresh,replaced,created);
+        // the child is a fresh copy as well , so rotating it up does not touch the old version
+        if(copy->left_ptr->priority > copy->priority){
+            index_node* child = copy->left_ptr;
+            copy->left_ptr = child->right_ptr;
+            child->right_ptr = copy;
+            pull(copy);
+            pull(child);
+            return child;
+        }
     }
+    else {
+        copy->right_ptr = insert_copy(node->right_ptr,fresh,replaced,created);
+        if(copy->right_ptr->priority > copy->priority){
+            index_node* child = copy->right_ptr;
+            copy->right_ptr = child->left_ptr;
+            child->left_ptr = copy;
+            pull(copy);
+            pull(child);
+            return child;
+        }
+    }
+    pull(copy);
+    return copy;
+}
 
-    bool check = false;
-    int mid = (left + right) / 2 ;
+static index_node* merge_copy(index_node* l, index_node* r, vector<index_node*> &replaced, vector<index_node*>* created = 0){
+    if(!l) {return r;}
+    if(!r) {return l;}
 
-    if(new_data.player_id <= mid && node->left_ptr){
-        check = update(node->left_ptr,left,mid,new_data);
+    index_node* copy ;
+    if(l->priority > r->priority){
+        copy = new index_node(*l);
+        replaced.push_back(l);
+        copy->right_ptr = merge_copy(l->right_ptr,r,replaced,created);
+    }
+    else {
+        copy = new index_node(*r);
+        replaced.push_back(r);
+        copy->left_ptr = merge_copy(l,r->left_ptr,replaced,created);
     }
+    if(created) {created->push_back(copy);}
+    pull(copy);
+    return copy;
+}
 
-    else if(new_data.player_id>mid && node->right_ptr){ 
-        check = update(node->right_ptr,mid+1,right,new_data);
+// created , when given , receives every node allocated by the call
+static index_node* erase_copy(index_node* node, const player_data &key, vector<index_node*> &replaced, vector<index_node*>* created = 0){
+    if(!node) {return 0;}
 
+    if(!key_less(node->p,key) && !key_less(key,node->p)){
+        replaced.push_back(node);
+        return merge_copy(node->left_ptr,node->right_ptr,replaced,created);
     }
 
-    if (check){
-        player_data left_player ;
-        player_data right_player;
+    index_node* copy = new index_node(*node);
+    replaced.push_back(node);
+    if(created) {created->push_back(copy);}
+    if(key_less(key,node->p)) {copy->left_ptr = erase_copy(node->left_ptr,key,replaced,created);}
+    else {copy->right_ptr = erase_copy(node->right_ptr,key,replaced,created);}
+    pull(copy);
+    return copy;
+}
 
-        if(node->left_ptr){
-            left_player = node->left_ptr->p;
+// number of players whose key is smaller than key
+int count_less(const player_data &key) const {
+    int count = 0;
+    for(index_node* node = root_node; node; ){
+        LB_VISIT();
+        if(key_less(node->p,key)){
+            count += size_of(node->left_ptr) + 1;
+            node = node->right_ptr;
         }
-        else {left_player=player_data();}
+        else {node = node->left_ptr;}
+    }
+    return count;
+}
 
-        if(node->right_ptr){
-            right_player = node->right_ptr->p;
+// the player at position i (0 based) of the order , the empty player if i is out of range
+player_data select(int i) const {
+    for(index_node* node = root_node; node; ){
+        LB_VISIT();
+        int left_size = size_of(node->left_ptr);
+        if(i < left_size) {node = node->left_ptr;}
+        else if(i == left_size) {return node->p;}
+        else {
+            i -= left_size + 1;
+            node = node->right_ptr;
         }
-        else {right_player=player_data();}
-
-        node->p = player_data :: best_player (left_player,right_player);
-
-
     }
+    return player_data();
+}
 
-    return check;
+};
 
+// finish_time index : a player's position in the (finish_time , player_id) order plays the role of its
+// compressed time coordinate , kept in a balanced tree instead of a static array because times change online
+template <class Agg>
+class basic_time_index : public ordered_index<finish_time_order,Agg> {
+
+private:
 
+typedef ordered_index<finish_time_order,Agg> base;
+typedef typename base::index_node index_node;
+using base::root_node;
+
+// best player of the subtree whose finish_time >= start
+static player_data suffix_best(index_node* node, int start){
+    player_data best ;
+    while(node){
+        LB_VISIT();
+        if(node->p.finish_time >= start){
+            best = player_data :: best_player(best,node->p);
+            if(node->right_ptr) {best = player_data :: best_player(best,node->right_ptr->best);}
+            node = node->left_ptr;
+        }
+        else {node = node->right_ptr;}
+    }
+    return best;
+}
 
+// best player of the subtree whose finish_time <= finish
+static player_data prefix_best(index_node* node, int finish){
+    player_data best ;
+    while(node){
+        LB_VISIT();
+        if(node->p.finish_time <= finish){
+            best = player_data :: best_player(best,node->p);
+            if(node->left_ptr) {best = player_data :: best_player(best,node->left_ptr->best);}
+            node = node->right_ptr;
+        }
+        else {node = node->left_ptr;}
+    }
+    return best;
 }
 
-player_data query_by_index_helper(tree_node* &node, int left, int right,int start_id, int end_id){
+// suffix_best and prefix_best with the aggregates , one walk each
+static range_summary<Agg> suffix_summary(index_node* node, int start){
+    range_summary<Agg> s ;
+    while(node){
+        LB_VISIT();
+        if(node->p.finish_time >= start){
+            s = range_summary<Agg> :: join(s,player_summary(node->p));
+            if(node->right_ptr) {s = range_summary<Agg> :: join(s,subtree_summary(node->right_ptr));}
+            node = node->left_ptr;
+        }
+        else {node = node->right_ptr;}
+    }
+    return s;
+}
 
-if(!node || end_id<left || start_id>right){return player_data();}
+static range_summary<Agg> prefix_summary(index_node* node, int finish){
+    range_summary<Agg> s ;
+    while(node){
+        LB_VISIT();
+        if(node->p.finish_time <= finish){
+            s = range_summary<Agg> :: join(s,player_summary(node->p));
+            if(node->left_ptr) {s = range_summary<Agg> :: join(s,subtree_summary(node->left_ptr));}
+            node = node->right_ptr;
+        }
+        else {node = node->left_ptr;}
+    }
+    return s;
+}
 
-if(start_id <=left && right <= end_id){
-    return node->p;
+static range_summary<Agg> player_summary(const player_data &p){
+    range_summary<Agg> s ;
+    s.best = p;
+    static_cast<typename Agg::value&>(s) = Agg::of(p);
+    return s;
 }
 
+static range_summary<Agg> subtree_summary(const index_node* node){
+    range_summary<Agg> s ;
+    s.best = node->best;
+    static_cast<typename Agg::value&>(s) = *node;
+    return s;
+}
 
-int mid = (left + right) / 2;
-player_data left_player = query_by_index_helper(node->left_ptr, left, mid, start_id, end_id);
-player_data right_player = query_by_index_helper(node->right_ptr, mid + 1, right, start_id, end_id);
+// a top_k candidate : either one player , or every player of a subtree (then value is the subtree best)
+struct candidate {
+    player_data value;
+    index_node* node;
+    bool whole;
+};
 
-return player_data::best_player(left_player, right_player);
+struct candidate_order {
+    bool operator()(const candidate &a, const candidate &b) const {
+        return player_data :: ranks_higher(b.value,a.value);
+    }
+};
 
+static void push_candidate(priority_queue<candidate,vector<candidate>,candidate_order> &heap, index_node* node, bool whole){
+    if(!node) {return;}
+    candidate c;
+    c.value = whole ? node->best : node->p;
+    c.node = node;
+    c.whole = whole;
+    if(c.value.player_id != -1) {heap.push(c);}
 }
 
-
 public:
 
-segment_tree(int size) :
-root_node(0),max_num_of_players(size)
-{this->reached_index = -1;} // initialize reached_index to -1
+// best first search : the interval splits into O(log n) subtrees , a popped subtree is opened into its root
+// player and its two children , so every answer costs one root to leaf walk of the heap , about O(k log n)
+vector<player_data> top_k(int start_time, int finish_time, int k) const {
 
-void insert_into_tree(player_data p){
+    vector<player_data> result;
+    if(k <= 0) {return result;}
 
-    this->reached_index++;
-    player_data p1(p.score,this->reached_index,p.finish_time);
-    return insert_helper_function(root_node,0,max_num_of_players-1,this->reached_index,p1);
+    priority_queue<candidate,vector<candidate>,candidate_order> heap;
+    index_node* node = root_node;
 
-}
-// the tree is created by indices , not time ,thus complexity is close to O(n)
-player_data query_the_tree_by_time(int start_time, int finish_time){
-    if(start_time < 0 || finish_time< 0 ){
-        cerr<<"Wrong Interval";
-        return player_data();
+    while(node){
+        if(node->p.finish_time < start_time) {node = node->right_ptr;}
+        else if(node->p.finish_time > finish_time) {node = node->left_ptr;}
+        else {
+            push_candidate(heap,node,false);
+
+            for(index_node* l = node->left_ptr; l; ){
+                if(l->p.finish_time >= start_time){
+                    push_candidate(heap,l,false);
+                    push_candidate(heap,l->right_ptr,true);
+                    l = l->left_ptr;
+                }
+                else {l = l->right_ptr;}
+            }
+            for(index_node* r = node->right_ptr; r; ){
+                if(r->p.finish_time <= finish_time){
+                    push_candidate(heap,r,false);
+                    push_candidate(heap,r->left_ptr,true);
+                    r = r->right_ptr;
+                }
+                else {r = r->left_ptr;}
+            }
+            break;
+        }
     }
-    return query_helper_function(root_node,start_time,finish_time);
 
+    while(!heap.empty() && (int)result.size() < k){
+        candidate c = heap.top();
+        heap.pop();
+        LB_VISIT();
+
+        if(!c.whole){
+            result.push_back(c.value);
+            continue;
+        }
+        push_candidate(heap,c.node,false);
+        push_candidate(heap,c.node->left_ptr,true);
+        push_candidate(heap,c.node->right_ptr,true);
+    }
+    return result;
 }
-player_data query_the_tree_by_id(int begin_id, int end_id){
 
-    if(begin_id < 0 || end_id > this->reached_index){
+// O(log n) : walk down to the first node inside the interval , then only one side of each subtree can be partial
+player_data query(int start_time, int finish_time) const {
+    return query_root(root_node,start_time,finish_time);
+}
 
-        cerr<<"Invalid ID "<<endl;
-        return player_data();
+// same query on any version of the index , used by the path copying trees
+static player_data query_root(index_node* node, int start_time, int finish_time){
+
+    while(node){
+        LB_VISIT();
+        if(node->p.finish_time < start_time) {node = node->right_ptr;}
+        else if(node->p.finish_time > finish_time) {node = node->left_ptr;}
+        else {
+            player_data best = node->p;
+            best = player_data :: best_player(best,suffix_best(node->left_ptr,start_time));
+            best = player_data :: best_player(best,prefix_best(node->right_ptr,finish_time));
+            return best;
+        }
     }
-    else if (begin_id > end_id){
+    return player_data();
+}
 
-        cerr<<"Invalid Interval"<<endl;
-        return player_data();
+// query with every aggregate of Agg over the same players , still one O(log n) walk
+range_summary<Agg> summary(int start_time, int finish_time) const {
+
+    index_node* node = root_node;
+    while(node){
+        LB_VISIT();
+        if(node->p.finish_time < start_time) {node = node->right_ptr;}
+        else if(node->p.finish_time > finish_time) {node = node->left_ptr;}
+        else {
+            range_summary<Agg> s = suffix_summary(node->left_ptr,start_time);
+            s = range_summary<Agg> :: join(s,player_summary(node->p));
+            return range_summary<Agg> :: join(s,prefix_summary(node->right_ptr,finish_time));
+        }
     }
+    return range_summary<Agg>();
+}
 
-    return query_by_index_helper(root_node, 0, max_num_of_players - 1, begin_id, end_id);
+};
+
+typedef basic_time_index<no_aggregates> time_index;
+
+// global ranking : position of every player in the best_player order
+class rank_index : public ordered_index<rank_order> {
+
+public:
 
+// 1 based rank of a player , given its current data
+int rank_of(const player_data &p) const {
+    return count_less(p) + 1;
 }
 
-bool update_player_data(player_data new_player_data){
-    
-    bool check = false;
+// the player holding a 1 based rank , the empty player if there is none
+player_data player_at(int rank) const {
+    return select(rank - 1);
+}
 
-    if(new_player_data.player_id < 0 || new_player_data.player_id > this->reached_index){
-        cerr<<"Invalid Player ID"<<endl;
-        return false;
-    }
+};
 
-    else{
+// two dimensional index : a segment tree over blocks of 32 player IDs whose every node keeps a finish_time index
+// of the players below it , an ID range is its two partial end blocks , scanned directly , plus O(log n) nodes
+// each answering the time window in O(log n) , so queries and updates are O(log^2 n)
+// below block level a scan of 32 adjacent players beats 5 more levels of treaps , and memory stays
+// O(n log(n / 32)) index nodes
+class id_time_index {
 
-        player_data p1(new_player_data.score,new_player_data.player_id,new_player_data.finish_time);
-         check = update(root_node,0,max_num_of_players-1,p1);
-        return check;
+private:
+
+static const int block_bits = 5;
+static const int block_size = 1 << block_bits;
+
+vector<player_data> players ; // by ID , for the partial blocks
+int blocks ; // number of leaf blocks , rounded up to a power of two
+vector<time_index*> nodes ; // implicit heap over blocks , 0 until a player lands below the node
+
+time_index* at(int i){
+    if(!nodes[i]) {nodes[i] = new time_index();}
+    return nodes[i];
+}
+
+player_data scan(int begin_id, int end_id, int start_time, int finish_time) const {
+    player_data best ;
+    for(int id = begin_id; id <= end_id; id++){
+        const player_data &p = players[id];
+        if(p.finish_time >= start_time && p.finish_time <= finish_time) {best = player_data :: best_player(best,p);}
     }
-    return check;  
+    return best;
+}
+
+public:
+
+id_time_index(int size) : blocks(1)
+{
+    int needed = (size + block_size - 1) / block_size;
+    while(blocks < needed) {blocks <<= 1;}
+    players.assign((size_t)blocks * block_size,player_data());
+    nodes.assign(2*blocks,0);
+}
+
+~id_time_index(){
+    for(size_t i = 0; i < nodes.size(); i++) {delete nodes[i];}
+}
+
+id_time_index(const id_time_index &) = delete;
+id_time_index& operator=(const id_time_index &) = delete;
+
+void add(const player_data &p){
+    players[p.player_id] = p;
+    for(int i = (p.player_id >> block_bits) + blocks; i >= 1; i >>= 1) {at(i)->insert(p);}
+}
+
+void replace(const player_data &old_data, const player_data &new_data){
+    players[new_data.player_id] = new_data;
+    for(int i = (new_data.player_id >> block_bits) + blocks; i >= 1; i >>= 1) {at(i)->replace(old_data,new_data);}
+}
+
+void remove(const player_data &p){
+    players[p.player_id] = player_data();
+    for(int i = (p.player_id >> block_bits) + blocks; i >= 1; i >>= 1) {at(i)->erase(p);}
+}
+
+// batch must be in ID order , gaps allowed , every node above them gets its slice in one build_from
+void build_from(const vector<player_data> &batch){
+    if(batch.empty()) {return;}
+    int first = batch.front().player_id;
+    int last = batch.back().player_id;
+    for(size_t i = 0; i < batch.size(); i++) {players[batch[i].player_id] = batch[i];}
+
+    struct id_less {
+        bool operator()(const player_data &p, int id) const {return p.player_id < id;}
+    };
+    for(int level = 0; (1 << level) <= blocks; level++){
+        for(int i = ((first >> block_bits) + blocks) >> level; i <= ((last >> block_bits) + blocks) >> level; i++){
+            int low = max(first,((i << level) - blocks) << block_bits);
+            int high = min(last,(((i + 1) << level) - blocks) * block_size - 1);
+            vector<player_data>::const_iterator b = lower_bound(batch.begin(),batch.end(),low,id_less());
+            vector<player_data>::const_iterator e = lower_bound(b,batch.end(),high + 1,id_less());
+            if(b != e) {at(i)->build_from(vector<player_data>(b,e));}
+        }
+    }
+}
+
+// IDs the index can hold
+int capacity() const {
+    return blocks * block_size;
+}
+
+// doubles the ID range : the old heap becomes the left half of the new one , level by level ,
+// only the new root is built , from the players so far
+void grow(){
+    vector<time_index*> grown(4*blocks,0);
+    for(int level = 1; level < 2*blocks; level <<= 1){
+        for(int i = level; i < 2*level; i++) {grown[i + level] = nodes[i];}
+    }
+    vector<player_data> present;
+    for(size_t i = 0; i < players.size(); i++){
+        if(players[i].player_id != -1) {present.push_back(players[i]);}
+    }
+    if(!present.empty()){
+        grown[1] = new time_index();
+        grown[1]->build_from(present);
+    }
+
+    nodes.swap(grown);
+    blocks *= 2;
+    players.resize((size_t)blocks * block_size,player_data());
+}
+
+// best player with an ID in [begin_id , end_id] and a finish_time in [start_time , finish_time]
+player_data query(int begin_id, int end_id, int start_time, int finish_time){
+    int first_block = (begin_id + block_size - 1) >> block_bits;
+    int last_block = ((end_id + 1) >> block_bits) - 1;
+    if(first_block > last_block) {return scan(begin_id,end_id,start_time,finish_time);}
+
+    player_data best = player_data :: best_player(scan(begin_id,(first_block << block_bits) - 1,start_time,finish_time),
+                                                  scan((last_block + 1) << block_bits,end_id,start_time,finish_time));
+    for(int l = first_block + blocks, r = last_block + blocks + 1; l < r; l >>= 1, r >>= 1){
+        if(l & 1){
+            if(nodes[l]) {best = player_data :: best_player(best,nodes[l]->query(start_time,finish_time));}
+            l++;
+        }
+        if(r & 1){
+            r--;
+            if(nodes[r]) {best = player_data :: best_player(best,nodes[r]->query(start_time,finish_time));}
+        }
+    }
+    return best;
+}
+
+};
+
+// every index kept next to the tree , updated together with the leaves , the finish_time index keeps the
+// aggregates of Agg
+template <class Agg>
+class basic_secondary_indexes {
+
+public:
+
+basic_time_index<Agg> times ;
+rank_index ranks ;
+id_time_index* id_times ; // built on the first combined query , maintained from then on
+
+basic_secondary_indexes() : id_times(0)
+{}
+
+~basic_secondary_indexes(){
+    delete id_times;
+}
+
+basic_secondary_indexes(const basic_secondary_indexes &) = delete;
+basic_secondary_indexes& operator=(const basic_secondary_indexes &) = delete;
+
+void add(const player_data &p){
+    times.insert(p);
+    ranks.insert(p);
+    if(id_times) {id_times->add(p);}
+}
+
+void replace(const player_data &old_data, const player_data &new_data){
+    times.replace(old_data,new_data);
+    ranks.replace(old_data,new_data);
+    if(id_times) {id_times->replace(old_data,new_data);}
+}
+
+void remove(const player_data &p){
+    times.erase(p);
+    ranks.erase(p);
+    if(id_times) {id_times->remove(p);}
+}
+
+// players in ID order , removed slots (the player_data() sentinel) are skipped
+void build_from(const vector<player_data> &players){
+    vector<player_data> present = present_only(players);
+    times.build_from(present);
+    ranks.build_from(present);
+    if(id_times) {id_times->build_from(present);}
+}
+
+static vector<player_data> present_only(const vector<player_data> &players){
+    vector<player_data> present;
+    present.reserve(players.size());
+    for(size_t i = 0; i < players.size(); i++){
+        if(players[i].player_id != -1) {present.push_back(players[i]);}
+    }
+    return present;
+}
+
+// drops everything and indexes players instead , the combined index stays enabled if it was
+void reset(int size, const vector<player_data> &players){
+    times.clear();
+    ranks.clear();
+    if(id_times){
+        delete id_times;
+        id_times = new id_time_index(size);
+    }
+    build_from(players);
+}
+
+// the board now holds IDs up to size - 1
+void grow(int size){
+    while(id_times && id_times->capacity() < size) {id_times->grow();}
+}
+
+// players are every player so far , in ID order
+void enable_id_times(int size, const vector<player_data> &players){
+    if(id_times) {return;}
+    id_times = new id_time_index(size);
+    id_times->build_from(present_only(players));
+}
+
+};
+
+typedef basic_secondary_indexes<no_aggregates> secondary_indexes;
+
+// one version of the leaderboard : roots of the ID tree and of the finish_time index ,
+// never modified once other versions or readers can see it
+struct leaderboard_version {
+    tree_node* id_root ;
+    index_node* time_root ;
+    int reached_index ;
+};
+
+// path copying version of the ID tree : nodes are never modified once reachable from a published root ,
+// an update copies the nodes from the root to the leaf and reports the originals in replaced
+class path_copy_tree {
+
+public:
+
+static tree_node* set_leaf(tree_node* node, int left, int right, int index, player_data data, vector<tree_node*> &replaced){
+
+    tree_node* copy ;
+    if(node){
+        copy = new tree_node(*node);
+        replaced.push_back(node);
+    }
+    else {copy = new tree_node(left,right);}
+
+    if(left == right){
+        copy->p = data;
+        return copy;
+    }
+
+    int mid = (left + right) / 2;
+    if(index <= mid) {copy->left_ptr = set_leaf(copy->left_ptr,left,mid,index,data,replaced);}
+    else {copy->right_ptr = set_leaf(copy->right_ptr,mid+1,right,index,data,replaced);}
+
+    player_data p1 ;
+    player_data p2 ;
+    if(copy->left_ptr) {p1 = copy->left_ptr->p;}
+    if(copy->right_ptr) {p2 = copy->right_ptr->p;}
+    copy->p = player_data :: best_player(p1,p2);
+    return copy;
+}
+
+static player_data query(const tree_node* node, int left, int right, int start_id, int end_id){
+
+    if(!node || end_id<left || start_id>right) {return player_data();}
+
+    if(start_id <= left && right <= end_id) {return node->p;}
+
+    int mid = (left + right) / 2;
+    return player_data :: best_player(query(node->left_ptr,left,mid,start_id,end_id),
+                                      query(node->right_ptr,mid+1,right,start_id,end_id));
+}
+
+};
+
+// validates a batch of updates and keeps only the last write per player_id
+// success[i] tells if update i was accepted , the surviving updates come back sorted by player_id
+vector<player_data> coalesce_updates(const vector<player_data> &updates, int reached_index, vector<bool> &success){
+
+    success.assign(updates.size(),false);
+    vector<pair<int,int> > order; // (player_id , position in the batch)
+
+    for(size_t i = 0; i < updates.size(); i++){
+        if(updates[i].player_id < 0 || updates[i].player_id > reached_index){
+            cerr<<"Invalid Player ID"<<endl;
+            continue;
+        }
+        success[i] = true;
+        order.push_back(make_pair(updates[i].player_id,(int)i));
+    }
+    sort(order.begin(),order.end());
+
+    vector<player_data> batch;
+    for(size_t i = 0; i < order.size(); i++){
+        if(i + 1 < order.size() && order[i+1].first == order[i].first) {continue;} // a later write wins
+        const player_data &u = updates[order[i].second];
+        batch.push_back(player_data(u.score,u.player_id,u.finish_time));
+    }
+    return batch;
+}
+
+// immutable range best over players in ID order : level k keeps , for every start , the position of the best
+// player of the 2^k players from there , two overlapping blocks cover any range , so a query is O(1)
+// positions are stored instead of players , a third of the memory , level 0 is the players themselves
+class sparse_table {
+
+private:
+
+vector<player_data> players ;
+vector<vector<int> > levels ; // levels[k - 1] for blocks of 2^k players
+
+int better(int a, int b) const {
+    return player_data :: ranks_higher(players[a],players[b]) ? a : b;
+}
+
+static int log2_floor(int length){
+    return 31 - __builtin_clz((unsigned)length);
+}
+
+public:
+
+sparse_table(const vector<player_data> &by_id) : players(by_id)
+{
+    int count = (int)players.size();
+    for(int k = 1; (1 << k) <= count; k++){
+        int half = 1 << (k - 1);
+        levels.push_back(vector<int>(count - (1 << k) + 1));
+        vector<int> &level = levels.back();
+        for(int i = 0; i < (int)level.size(); i++){
+            int a = k == 1 ? i : levels[k-2][i];
+            int b = k == 1 ? i + half : levels[k-2][i + half];
+            level[i] = better(a,b);
+        }
+    }
+}
+
+// position of the best player of [begin , end]
+int best_index(int begin, int end) const {
+    if(begin == end) {return begin;}
+    int k = log2_floor(end - begin + 1);
+    const vector<int> &level = levels[k-1];
+    return better(level[begin],level[end - (1 << k) + 1]);
+}
+
+player_data query(int begin, int end) const {
+    return players[best_index(begin,end)];
+}
+
+const vector<player_data>& by_id() const {
+    return players;
+}
+
+// bytes held by the table , the players included
+size_t memory_bytes() const {
+    size_t bytes = players.capacity() * sizeof(player_data);
+    for(size_t k = 0; k < levels.size(); k++) {bytes += levels[k].capacity() * sizeof(int);}
+    return bytes;
+}
+
+};
+
+// open addressing map from external 64 bit account IDs to tree slots , one flat array of (key , slot) pairs
+// with linear probing , a lookup usually touches a single cache line instead of chasing a bucket list
+// removed entries become tombstones , the table is rebuilt once live entries plus tombstones pass half of it
+class external_id_map {
+
+private:
+
+static const int empty_slot = -1;
+static const int erased_slot = -2;
+
+struct entry {
+    long long key ;
+    int slot ; // empty_slot , erased_slot or the tree slot of key
+};
+
+vector<entry> table ;
+size_t mask ;  // table size - 1 , the size is a power of two
+size_t live ;
+size_t used ;  // live entries plus tombstones
+
+static size_t hash_of(long long key){
+    // splitmix64 finalizer , consecutive account IDs land far apart
+    unsigned long long x = (unsigned long long)key;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return (size_t)(x ^ (x >> 31));
+}
+
+// index of key , or of the first free entry of its probe sequence (a tombstone if one was passed)
+size_t probe(long long key) const {
+    size_t i = hash_of(key) & mask;
+    size_t reuse = table.size();
+    while(table[i].slot != empty_slot){
+        if(table[i].slot == erased_slot){
+            if(reuse == table.size()) {reuse = i;}
+        }
+        else if(table[i].key == key) {return i;}
+        i = (i + 1) & mask;
+    }
+    return reuse != table.size() ? reuse : i;
+}
+
+void rehash(size_t size){
+    vector<entry> old;
+    old.swap(table);
+    entry blank = {0,empty_slot};
+    table.assign(size,blank);
+    mask = size - 1;
+    used = live;
+    for(size_t i = 0; i < old.size(); i++){
+        if(old[i].slot >= 0) {table[probe(old[i].key)] = old[i];}
+    }
+}
+
+public:
+
+external_id_map() : mask(0),live(0),used(0)
+{
+    rehash(16);
+}
+
+// tree slot of key , -1 if key is not mapped
+int find(long long key) const {
+    const entry &e = table[probe(key)];
+    return e.slot >= 0 && e.key == key ? e.slot : -1;
+}
+
+// false if key is already mapped
+bool insert(long long key, int slot){
+    if(2 * (used + 1) > table.size()) {rehash(2 * live + 2 > table.size() / 2 ? 2 * table.size() : table.size());}
+    size_t i = probe(key);
+    if(table[i].slot >= 0) {return false;}
+    if(table[i].slot == empty_slot) {used++;}
+    table[i].key = key;
+    table[i].slot = slot;
+    live++;
+    return true;
+}
+
+bool erase(long long key){
+    size_t i = probe(key);
+    if(table[i].slot < 0) {return false;}
+    table[i].slot = erased_slot;
+    live--;
+    return true;
+}
+
+size_t size() const {
+    return live;
+}
+
+size_t memory_bytes() const {
+    return table.capacity() * sizeof(entry);
+}
+
+};
+
+// players that have an external ID , kept sorted by it in a treap whose every node keeps the best player of its
+// subtree , the best player of an external ID range is one O(log n) walk , as in the finish_time index
+class external_order_index {
+
+private:
+
+struct node {
+    long long key ;
+    player_data p ;
+    player_data best ; // best player of the subtree
+    unsigned priority ;
+    node* left_ptr ;
+    node* right_ptr ;
+
+    node(long long key, const player_data &p, unsigned priority) :
+    key(key),p(p),best(p),priority(priority),left_ptr(0),right_ptr(0)
+    {}
+};
+
+node* root_node ;
+unsigned seed ;
+
+unsigned next_priority(){
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void pull(node* n){
+    player_data left_best ;
+    player_data right_best ;
+    if(n->left_ptr) {left_best = n->left_ptr->best;}
+    if(n->right_ptr) {right_best = n->right_ptr->best;}
+    n->best = player_data :: best_player(player_data :: best_player(left_best,n->p),right_best);
+}
+
+// l gets the keys smaller than key , r gets the rest
+static void split(node* n, long long key, node* &l, node* &r){
+    if(!n) {l = r = 0; return;}
+    LB_VISIT();
+    if(n->key < key){
+        split(n->right_ptr,key,n->right_ptr,r);
+        l = n;
+    }
+    else {
+        split(n->left_ptr,key,l,n->left_ptr);
+        r = n;
+    }
+    pull(n);
+}
+
+static node* merge(node* l, node* r){
+    if(!l) {return r;}
+    if(!r) {return l;}
+    LB_VISIT();
+    if(l->priority > r->priority){
+        l->right_ptr = merge(l->right_ptr,r);
+        pull(l);
+        return l;
+    }
+    r->left_ptr = merge(l,r->left_ptr);
+    pull(r);
+    return r;
+}
+
+// unlinks the node holding key and returns it , 0 if there is none
+static node* detach(node* &n, long long key){
+    if(!n) {return 0;}
+    LB_VISIT();
+    if(n->key == key){
+        node* found = n;
+        n = merge(n->left_ptr,n->right_ptr);
+        found->left_ptr = found->right_ptr = 0;
+        return found;
+    }
+    node* found = key < n->key ? detach(n->left_ptr,key) : detach(n->right_ptr,key);
+    if(found) {pull(n);}
+    return found;
+}
+
+// rewrites the player of key and the best players on its path , false if key is not in the index
+static bool assign(node* n, long long key, const player_data &p){
+    if(!n) {return false;}
+    LB_VISIT();
+    bool found;
+    if(n->key == key){
+        n->p = p;
+        found = true;
+    }
+    else {found = assign(key < n->key ? n->left_ptr : n->right_ptr,key,p);}
+    if(found) {pull(n);}
+    return found;
+}
+
+// best player of the subtree whose key >= begin
+static player_data suffix_best(const node* n, long long begin){
+    player_data best ;
+    while(n){
+        LB_VISIT();
+        if(n->key >= begin){
+            best = player_data :: best_player(best,n->p);
+            if(n->right_ptr) {best = player_data :: best_player(best,n->right_ptr->best);}
+            n = n->left_ptr;
+        }
+        else {n = n->right_ptr;}
+    }
+    return best;
+}
+
+// best player of the subtree whose key <= end
+static player_data prefix_best(const node* n, long long end){
+    player_data best ;
+    while(n){
+        LB_VISIT();
+        if(n->key <= end){
+            best = player_data :: best_player(best,n->p);
+            if(n->left_ptr) {best = player_data :: best_player(best,n->left_ptr->best);}
+            n = n->right_ptr;
+        }
+        else {n = n->left_ptr;}
+    }
+    return best;
+}
+
+static void destroy(node* n){
+    if(!n) {return;}
+    destroy(n->left_ptr);
+    destroy(n->right_ptr);
+    delete n;
+}
+
+public:
+
+external_order_index() : root_node(0), seed(2463534242u)
+{}
+
+~external_order_index(){
+    destroy(root_node);
+}
+
+external_order_index(const external_order_index &) = delete;
+external_order_index& operator=(const external_order_index &) = delete;
+
+// key must not be in the index yet
+void insert(long long key, const player_data &p){
+    LB_ALLOC();
+    node* l ;
+    node* r ;
+    split(root_node,key,l,r);
+    root_node = merge(merge(l,new node(key,p,next_priority())),r);
+}
+
+bool erase(long long key){
+    node* found = detach(root_node,key);
+    delete found;
+    return found != 0;
+}
+
+bool assign(long long key, const player_data &p){
+    return assign(root_node,key,p);
+}
+
+// best player whose key is in [begin , end] , O(log n) : down to the first node inside , then one side of each
+// subtree below it can be partial
+player_data query(long long begin, long long end) const {
+    for(const node* n = root_node; n; ){
+        LB_VISIT();
+        if(n->key < begin) {n = n->right_ptr;}
+        else if(n->key > end) {n = n->left_ptr;}
+        else {
+            player_data best = n->p;
+            best = player_data :: best_player(best,suffix_best(n->left_ptr,begin));
+            return player_data :: best_player(best,prefix_best(n->right_ptr,end));
+        }
+    }
+    return player_data();
+}
+
+};
+
+// the leaderboard : a segment tree over player IDs , every node keeps the best player of its range and the
+// aggregates of the compile time policy Agg , segment_tree below keeps no aggregates
+template <class Agg>
+class basic_segment_tree {
+
+private:
+
+typedef basic_tree_node<Agg> tree_node;
+typedef typename Agg::value aggregate;
+
+tree_node * root_node ; 
+int max_num_of_players;
+int reached_index ; // cannot be global , due multible instances of the segment tree will make indexing wrong
+basic_secondary_indexes<Agg> indexes ; // finish_time and rank indexes , kept in sync with the leaves
+basic_node_pool<tree_node> pool ; // owns every tree_node of this tree
+sparse_table* frozen ; // set between freeze and thaw , the ID tree is released meanwhile
+vector<aggregate> frozen_aggregates ; // with frozen , Agg of every ID block as an implicit heap over 2n slots ,
+                                      // leaves from n , left empty when Agg keeps nothing
+#ifdef LEADERBOARD_STATS
+mutable shared_tree_stats stats ; // counted by the const reads too
+#endif
+
+// a range add the secondary indexes have not seen yet
+struct score_shift {
+    int begin_id ;
+    int end_id ;
+    int delta ;
+};
+vector<score_shift> pending_shifts ; // range adds since the indexes were last caught up , oldest first
+
+vector<int> free_ids ;      // removed slots , the last one freed is handed out first
+vector<bool> vacant ;       // vacant[id] while slot id is on free_ids
+external_id_map external_ids ;
+vector<long long> external_of ; // slot -> external ID , only meaningful while external_ids maps it back
+external_order_index external_order ; // the players of external_ids sorted by external ID
+
+bool has_external_id(int id) const {
+    return id < (int)external_of.size() && external_ids.find(external_of[id]) == id;
+}
+
+// keeps external_order current for a player whose slot has an external ID , one flat map probe otherwise
+void external_changed(const player_data &p){
+    if(has_external_id(p.player_id)) {external_order.assign(external_of[p.player_id],p);}
+}
+
+bool is_vacant(int id) const {
+    return id < (int)vacant.size() && vacant[id];
+}
+
+// adds delta to every player below node , the best of the node stays the best since their order is unchanged
+// a removed slot stays the empty player
+static void shift(tree_node* node, int delta){
+    if(node->p.player_id != -1) {node->p.score += delta;}
+    Agg::shift(*node,delta);
+    node->pending += delta;
+}
+
+// hands the pending score of node to its children , every write does it on its way down
+static void push_down(tree_node* node){
+    if(!node->pending) {return;}
+    if(node->left_ptr) {shift(node->left_ptr,node->pending);}
+    if(node->right_ptr) {shift(node->right_ptr,node->pending);}
+    node->pending = 0;
+}
+
+// a leaf now holds data
+static void set_leaf(tree_node* node, const player_data &data){
+    node->p = data;
+    static_cast<aggregate&>(*node) = Agg::of(data);
+}
+
+// recomputes node from its children , a missing child is an empty range
+static void pull(tree_node* node){
+    player_data left_player ;
+    player_data right_player ;
+    aggregate &value = *node;
+    value = aggregate();
+    if(node->left_ptr) {left_player = node->left_ptr->p; value = *node->left_ptr;}
+    if(node->right_ptr) {right_player = node->right_ptr->p; value = Agg::combine(value,*node->right_ptr);}
+    node->p = player_data :: best_player(left_player,right_player);
+}
+
+// doubles the capacity until id fits , false when it cannot grow any further
+// the old tree becomes the left child of a new root : [0 , 2c - 1] splits at c - 1 , so every old node keeps its
+// bounds and nothing is rebuilt , a doubling costs O(1) and nodes still only exist below inserted IDs
+bool grow_to_fit(long long id){
+    if(id < max_num_of_players) {return true;}
+    while(id >= max_num_of_players){
+        if(max_num_of_players > INT_MAX / 2){
+            cerr<<"Leaderboard is full"<<endl;
+            return false;
+        }
+        int capacity = max_num_of_players < 1 ? 1 : 2*max_num_of_players;
+        if(root_node){
+            tree_node* root = pool.create(0,capacity-1);
+            root->left_ptr = root_node;
+            pull(root);
+            root_node = root;
+        }
+        max_num_of_players = capacity;
+    }
+    indexes.grow(max_num_of_players);
+    return true;
+}
+
+// mutations are refused while the board is frozen
+bool refuse_if_frozen(){
+    if(frozen) {cerr<<"Leaderboard is frozen"<<endl;}
+    return frozen != 0;
+}
+
+void insert_helper_function(tree_node* &node ,int left ,int right,int index,player_data data){
+
+if(!node) {
+    node = pool.create(left,right);
+}
+LB_VISIT();
+
+if(left == right){
+
+    set_leaf(node,data);
+    return;
+}
+
+push_down(node);
+int mid = (left + right) / 2 ;
+
+if (index <= mid){
+
+    insert_helper_function(node->left_ptr,left,mid,index,data);
+
+}
+else {
+    insert_helper_function(node->right_ptr,mid+1,right,index,data);
+}
+
+pull(node);
+}
+
+
+player_data query_helper_function(int start_interval,int end_interval) const {
+
+    return indexes.times.query(start_interval,end_interval);
+}
+
+
+
+
+
+
+bool update(tree_node* &node ,int left,int right ,player_data new_data) {
+
+    if(!node) {
+        return false ;
+    }
+    LB_VISIT();
+
+    if(left == right && left == new_data.player_id){
+
+        set_leaf(node,new_data);
+        return true ;
+    }
+
+    bool check = false;
+    push_down(node);
+    int mid = (left + right) / 2 ;
+
+    if(new_data.player_id <= mid && node->left_ptr){
+        check = update(node->left_ptr,left,mid,new_data);
+    }
+
+    else if(new_data.player_id>mid && node->right_ptr){ 
+        check = update(node->right_ptr,mid+1,right,new_data);
+
+    }
+
+    if (check){
+        pull(node);
+    }
+
+    return check;
+
+
+
+}
+
+// the nodes that exactly cover [start_id , end_id]
+void cover_nodes(tree_node* node, int left, int right, int start_id, int end_id, vector<tree_node*> &cover){
+
+    if(!node || end_id<left || start_id>right) {return;}
+    LB_VISIT();
+
+    if(start_id <= left && right <= end_id){
+        cover.push_back(node);
+        return;
+    }
+
+    push_down(node);
+    int mid = (left + right) / 2;
+    cover_nodes(node->left_ptr,left,mid,start_id,end_id,cover);
+    cover_nodes(node->right_ptr,mid+1,right,start_id,end_id,cover);
+}
+
+struct node_order {
+    bool operator()(const tree_node* a, const tree_node* b) const {
+        return player_data :: ranks_higher(b->p,a->p);
+    }
+};
+
+// writes every leaf of the sorted slice [first , last) below node , then recomputes node once
+// the replaced leaves are collected in old for the time index
+void update_batch_helper(tree_node* node, int left, int right, const player_data* first, const player_data* last, vector<player_data> &old){
+
+    LB_VISIT();
+    if(left == right){
+        old.push_back(node->p);
+        set_leaf(node,*first);
+        return;
+    }
+
+    push_down(node);
+    int mid = (left + right) / 2;
+    const player_data* split = first;
+    while(split != last && split->player_id <= mid) {split++;}
+
+    if(first != split) {update_batch_helper(node->left_ptr,left,mid,first,split,old);}
+    if(split != last) {update_batch_helper(node->right_ptr,mid+1,right,split,last,old);}
+
+    pull(node);
+}
+
+// builds the nodes of [left , right] that cover the first count players , children before parents
+tree_node* build_helper(int left, int right, const player_data* players, int count){
+
+    tree_node* node = pool.create(left,right);
+
+    if(left == right){
+        set_leaf(node,player_data(players[left].score,left,players[left].finish_time));
+        return node;
+    }
+
+    int mid = (left + right) / 2;
+    node->left_ptr = build_helper(left,mid,players,count);
+    if(mid + 1 < count){
+        node->right_ptr = build_helper(mid+1,right,players,count);
+    }
+
+    pull(node);
+    return node;
+}
+
+// top_k_by_id on the frozen form : a heap of ranges , each popped range gives its best player and splits around it
+vector<player_data> frozen_top_k(int begin_id, int end_id, int k){
+    struct range {
+        int best;
+        int begin;
+        int end;
+    };
+    const vector<player_data> &by_id = frozen->by_id();
+    auto worse = [&](const range &a, const range &b){ return player_data :: ranks_higher(by_id[b.best],by_id[a.best]); };
+    priority_queue<range,vector<range>,decltype(worse)> heap(worse);
+
+    vector<player_data> result;
+    range whole = {frozen->best_index(begin_id,end_id),begin_id,end_id};
+    heap.push(whole);
+    while(!heap.empty() && (int)result.size() < k){
+        range r = heap.top();
+        heap.pop();
+        if(by_id[r.best].player_id == -1) {break;} // only empty slots left
+        result.push_back(by_id[r.best]);
+        if(r.begin < r.best){
+            range left = {frozen->best_index(r.begin,r.best - 1),r.begin,r.best - 1};
+            heap.push(left);
+        }
+        if(r.best < r.end){
+            range right = {frozen->best_index(r.best + 1,r.end),r.best + 1,r.end};
+            heap.push(right);
+        }
+    }
+    return result;
+}
+
+// appends the slots of [left , right] up to reached_index in ID order , above is the pending score of the
+// ancestors of node , a slot without a node was removed and compacted away and comes out as the empty player
+void collect_leaves(const tree_node* node, int left, int right, vector<player_data> &out, int above = 0) const {
+    if(left > this->reached_index) {return;}
+    if(!node){
+        for(int id = left; id <= min(right,this->reached_index); id++) {out.push_back(player_data());}
+        return;
+    }
+    if(left == right){
+        out.push_back(node->p);
+        if(node->p.player_id != -1) {out.back().score += above;}
+        return;
+    }
+    int mid = (left + right) / 2;
+    collect_leaves(node->left_ptr,left,mid,out,above + node->pending);
+    collect_leaves(node->right_ptr,mid+1,right,out,above + node->pending);
+}
+
+// writes the players with IDs [first , last] below node , players[0] being ID base , creating missing nodes
+// every node on the way is recomputed once , however many of the new players sit below it
+void append_helper(tree_node* &node, int left, int right, int first, int last, const player_data* players, int base){
+
+    if(!node) {node = pool.create(left,right);}
+    LB_VISIT();
+
+    if(left == right){
+        set_leaf(node,player_data(players[left - base].score,left,players[left - base].finish_time));
+        return;
+    }
+
+    push_down(node);
+    int mid = (left + right) / 2;
+    if(first <= mid) {append_helper(node->left_ptr,left,mid,first,min(last,mid),players,base);}
+    if(last > mid) {append_helper(node->right_ptr,mid+1,right,max(first,mid+1),last,players,base);}
+
+    pull(node);
+}
+
+// above is the pending score of the ancestors of node , added on the way instead of pushed down ,
+// so a query never writes to the tree
+player_data query_by_index_helper(const tree_node* node, int left, int right,int start_id, int end_id, int above = 0) const {
+
+if(!node || end_id<left || start_id>right){return player_data();}
+LB_VISIT();
+
+if(start_id <=left && right <= end_id){
+    player_data best = node->p;
+    if(best.player_id != -1) {best.score += above;}
+    return best;
+}
+
+
+int mid = (left + right) / 2;
+player_data left_player = query_by_index_helper(node->left_ptr, left, mid, start_id, end_id, above + node->pending);
+player_data right_player = query_by_index_helper(node->right_ptr, mid + 1, right, start_id, end_id, above + node->pending);
+
+return player_data::best_player(left_player, right_player);
+
+}
+
+// query_by_index_helper with every aggregate of Agg , the pending scores above a cover node shift its aggregates
+range_summary<Agg> summary_helper(const tree_node* node, int left, int right, int start_id, int end_id, int above = 0) const {
+
+    if(!node || end_id<left || start_id>right) {return range_summary<Agg>();}
+    LB_VISIT();
+
+    if(start_id <= left && right <= end_id){
+        range_summary<Agg> s ;
+        s.best = node->p;
+        if(s.best.player_id != -1) {s.best.score += above;}
+        static_cast<aggregate&>(s) = *node;
+        Agg::shift(s,above);
+        return s;
+    }
+
+    int mid = (left + right) / 2;
+    return range_summary<Agg> :: join(summary_helper(node->left_ptr,left,mid,start_id,end_id,above + node->pending),
+                                      summary_helper(node->right_ptr,mid+1,right,start_id,end_id,above + node->pending));
+}
+
+// adds delta to the players of [start_id , end_id] , the nodes covering the range take it as a pending tag
+void add_range_helper(tree_node* node, int left, int right, int start_id, int end_id, int delta){
+
+    if(!node || end_id<left || start_id>right) {return;}
+    LB_VISIT();
+
+    if(start_id <= left && right <= end_id){
+        shift(node,delta);
+        return;
+    }
+
+    push_down(node);
+    int mid = (left + right) / 2;
+    add_range_helper(node->left_ptr,left,mid,start_id,end_id,delta);
+    add_range_helper(node->right_ptr,mid+1,right,start_id,end_id,delta);
+
+    pull(node);
+}
+
+// empties the leaf of id and recomputes its ancestors
+void remove_helper(tree_node* node, int left, int right, int id){
+
+    LB_VISIT();
+    if(left == right){
+        set_leaf(node,player_data());
+        return;
+    }
+
+    push_down(node);
+    int mid = (left + right) / 2;
+    if(id <= mid) {remove_helper(node->left_ptr,left,mid,id);}
+    else {remove_helper(node->right_ptr,mid+1,right,id);}
+
+    pull(node);
+}
+
+// gives every node below node back to the pool
+void release_subtree(tree_node* node, int &released){
+    if(!node) {return;}
+    release_subtree(node->left_ptr,released);
+    release_subtree(node->right_ptr,released);
+    pool.release(node);
+    released++;
+}
+
+// cuts off every subtree holding removed slots only , its best is the empty player exactly then
+void compact_helper(tree_node* &node, int &released){
+    if(!node) {return;}
+    if(node->p.player_id == -1){
+        release_subtree(node,released);
+        node = 0;
+        return;
+    }
+    compact_helper(node->left_ptr,released);
+    compact_helper(node->right_ptr,released);
+}
+
+// gives p the most recently freed slot , or the next ID , returns the slot or -1 when the board is full
+int place_player(player_data p){
+    sync_indexes();
+    int id;
+    if(!free_ids.empty()){
+        id = free_ids.back();
+        free_ids.pop_back();
+        vacant[id] = false;
+    }
+    else {
+        if(!grow_to_fit(this->reached_index + 1)) {return -1;}
+        id = ++this->reached_index;
+    }
+    player_data p1(p.score,id,p.finish_time);
+    indexes.add(p1);
+    insert_helper_function(root_node,0,max_num_of_players-1,id,p1);
+    return id;
+}
+
+
+public:
+
+// size is only the starting capacity , inserts past it double the board
+basic_segment_tree(int size) :
+root_node(0),max_num_of_players(size),frozen(0)
+{this->reached_index = -1;} // initialize reached_index to -1
+
+~basic_segment_tree(){
+    delete frozen;
+}
+
+basic_segment_tree(const basic_segment_tree &) = delete;
+basic_segment_tree& operator=(const basic_segment_tree &) = delete;
+
+// returns the ID the player got , -1 when the board is frozen or full
+int insert_into_tree(player_data p){
+
+    LB_OP_SCOPE(op_insert);
+    if(refuse_if_frozen()) {return -1;}
+    return place_player(p);
+
+}
+
+// inserts p under p.player_id , which must be a removed slot or the next ID , so a journal can put every player back
+// in the slot it had , false with "Invalid Player ID" for a slot that is taken or past the next ID
+bool insert_at(player_data p){
+
+    LB_OP_SCOPE(op_insert);
+    if(refuse_if_frozen()) {return false;}
+    int id = p.player_id;
+    if(id < 0 || id > this->reached_index + 1 || (id <= this->reached_index && !is_vacant(id))){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+    sync_indexes();
+    if(id <= this->reached_index){
+        free_ids.erase(find(free_ids.begin(),free_ids.end(),id));
+        vacant[id] = false;
+    }
+    else {
+        if(!grow_to_fit(id)) {return false;}
+        this->reached_index = id;
+    }
+    indexes.add(p);
+    insert_helper_function(root_node,0,max_num_of_players-1,id,p);
+    return true;
+}
+// same result as calling insert_into_tree for every player in order , but an empty tree is built bottom up
+// in O(n) from a single block of nodes instead of n root to leaf walks , a non empty tree gets the players
+// appended in one descent that recomputes every touched node once
+// freed slots are scattered , so the first players refill them one insert at a time before the rest is appended
+void build_from(const player_data* players, int count){
+
+    LB_OP_SCOPE(op_build);
+    if(refuse_if_frozen()) {return;}
+    sync_indexes();
+    for(; count > 0 && !free_ids.empty(); players++, count--) {place_player(*players);}
+    if(count <= 0) {return;}
+    if(!grow_to_fit((long long)this->reached_index + count)) {
+        count = max_num_of_players - 1 - this->reached_index;
+        if(count <= 0) {return;}
+    }
+
+    if(this->reached_index != -1){
+        int first = this->reached_index + 1;
+        pool.reserve(2*count + 64);
+        append_helper(root_node,0,max_num_of_players-1,first,first + count - 1,players,first);
+        vector<player_data> indexed(count);
+        for(int i = 0; i < count; i++){
+            indexed[i] = player_data(players[i].score,first + i,players[i].finish_time);
+        }
+        indexes.build_from(indexed);
+        this->reached_index += count;
+        return;
+    }
+
+    // every level holds at most one partially covered node , the fully covered ones are at most 2 * count
+    pool.reserve(2*count + 64);
+    root_node = build_helper(0,max_num_of_players-1,players,count);
+    this->reached_index = count - 1;
+
+    vector<player_data> indexed(count);
+    for(int i = 0; i < count; i++){
+        indexed[i] = player_data(players[i].score,i,players[i].finish_time);
+    }
+    indexes.build_from(indexed);
+}
+
+// the tree is created by indices , the time range is answered by the finish_time index in O(log n)
+player_data query_the_tree_by_time(int start_time, int finish_time) const {
+    LB_OP_SCOPE(op_query_by_time);
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+    return query_helper_function(start_time,finish_time);
+
+}
+player_data query_the_tree_by_id(int begin_id, int end_id) const {
+
+    LB_OP_SCOPE(op_query_by_id);
+    if(begin_id < 0 || end_id > this->reached_index){
+
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+
+    if(frozen) {return frozen->query(begin_id,end_id);}
+    return query_by_index_helper(root_node, 0, max_num_of_players - 1, begin_id, end_id);
+
+}
+
+// best player of an ID range together with every aggregate of Agg (count , total and mean score , earliest finish
+// with dashboard_aggregates) , one O(log n) walk over the same nodes as query_the_tree_by_id
+// a frozen board answers the best from its sparse_table and folds the aggregates from frozen_aggregates , O(log n)
+range_summary<Agg> query_range(int begin_id, int end_id) const {
+
+    LB_OP_SCOPE(op_query_by_id);
+    if(begin_id < 0 || end_id > this->reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return range_summary<Agg>();
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return range_summary<Agg>();
+    }
+
+    if(frozen){
+        range_summary<Agg> s ;
+        s.best = frozen->query(begin_id,end_id);
+        aggregate &value = s;
+        int count = (int)frozen_aggregates.size() / 2;
+        for(int l = begin_id + count, r = end_id + count + 1; count && l < r; l >>= 1, r >>= 1){
+            if(l & 1) {value = Agg::combine(value,frozen_aggregates[l++]);}
+            if(r & 1) {value = Agg::combine(value,frozen_aggregates[--r]);}
+        }
+        return s;
+    }
+    return summary_helper(root_node,0,max_num_of_players-1,begin_id,end_id);
+}
+
+// query_range over a finish_time range , answered by the finish_time index , which keeps the same aggregates
+range_summary<Agg> query_range_by_time(int start_time, int finish_time) const {
+    LB_OP_SCOPE(op_query_by_time);
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return range_summary<Agg>();
+    }
+    return indexes.times.summary(start_time,finish_time);
+}
+
+bool update_player_data(player_data new_player_data){
+    
+    LB_OP_SCOPE(op_update);
+    bool check = false;
+
+    if(refuse_if_frozen()) {return false;}
+    sync_indexes();
+    if(new_player_data.player_id < 0 || new_player_data.player_id > this->reached_index ||
+       is_vacant(new_player_data.player_id)){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    else{
+
+        player_data p1(new_player_data.score,new_player_data.player_id,new_player_data.finish_time);
+        player_data old = query_by_index_helper(root_node,0,max_num_of_players-1,p1.player_id,p1.player_id);
+         check = update(root_node,0,max_num_of_players-1,p1);
+        if(check){
+            indexes.replace(old,p1);
+            external_changed(p1);
+        }
+        return check;
+    }
+    return check;  
+}
+
+// the k best players of an ID range , best first
+// best first search from the cover nodes : popping a node pushes its children , a popped leaf is the next answer
+vector<player_data> top_k_by_id(int begin_id, int end_id, int k){
+
+    LB_OP_SCOPE(op_top_k);
+    vector<player_data> result;
+    if(begin_id < 0 || end_id > this->reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return result;
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return result;
+    }
+    if(frozen) {return frozen_top_k(begin_id,end_id,k);}
+
+    vector<tree_node*> cover;
+    cover_nodes(root_node,0,max_num_of_players-1,begin_id,end_id,cover);
+
+    priority_queue<tree_node*,vector<tree_node*>,node_order> heap;
+    for(size_t i = 0; i < cover.size(); i++){
+        if(cover[i]->p.player_id != -1) {heap.push(cover[i]);}
+    }
+
+    while(!heap.empty() && (int)result.size() < k){
+        tree_node* node = heap.top();
+        heap.pop();
+        LB_VISIT();
+
+        if(!node->left_ptr && !node->right_ptr){
+            result.push_back(node->p);
+            continue;
+        }
+        push_down(node);
+        if(node->left_ptr && node->left_ptr->p.player_id != -1) {heap.push(node->left_ptr);}
+        if(node->right_ptr && node->right_ptr->p.player_id != -1) {heap.push(node->right_ptr);}
+    }
+    return result;
+}
+
+// the k best players of a time range , best first
+vector<player_data> top_k_by_time(int start_time, int finish_time, int k) const {
+    LB_OP_SCOPE(op_top_k);
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return vector<player_data>();
+    }
+    return indexes.times.top_k(start_time,finish_time,k);
+}
+
+// global rank of a player (1 is the best) under the best_player ordering , O(log n)
+int rank_of(int player_id) const {
+    LB_OP_SCOPE(op_rank);
+    if(player_id < 0 || player_id > this->reached_index || is_vacant(player_id)){
+        cerr<<"Invalid Player ID"<<endl;
+        return -1;
+    }
+    player_data p = frozen ? frozen->query(player_id,player_id)
+                           : query_by_index_helper(root_node,0,max_num_of_players-1,player_id,player_id);
+    return indexes.ranks.rank_of(p);
+}
+
+// the player holding a global rank (1 is the best) , O(log n)
+player_data player_at(int rank) const {
+    LB_OP_SCOPE(op_rank);
+    if(rank < 1 || rank > this->reached_index + 1 - (int)free_ids.size()){
+        cerr<<"Invalid Rank"<<endl;
+        return player_data();
+    }
+    return indexes.ranks.player_at(rank);
+}
+
+// best player with an ID in [begin_id , end_id] who finished in [start_time , finish_time] , O(log^2 n)
+// the first call builds the two dimensional index in O(n log^2 n) , every later insert and update keeps it current
+player_data query_by_id_and_time(int begin_id, int end_id, int start_time, int finish_time){
+
+    LB_OP_SCOPE(op_query_2d);
+    if(begin_id < 0 || end_id > this->reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+
+    if(!indexes.id_times){
+        sync_indexes();
+        indexes.enable_id_times(max_num_of_players,players());
+    }
+    return indexes.id_times->query(begin_id,end_id,start_time,finish_time);
+}
+
+// applies a whole batch of updates : duplicates keep the last write , all leaves are written in one descent
+// and every dirty ancestor is recomputed exactly once instead of once per update
+vector<bool> apply_updates(const vector<player_data> &updates){
+
+    LB_OP_SCOPE(op_batch_update);
+    vector<bool> success;
+    if(refuse_if_frozen()) {return vector<bool>(updates.size(),false);}
+    sync_indexes();
+    vector<player_data> batch ;
+    if(free_ids.empty()) {batch = coalesce_updates(updates,this->reached_index,success);}
+    else {
+        // removed slots are refused like IDs past the end
+        vector<player_data> checked = updates;
+        for(size_t i = 0; i < checked.size(); i++){
+            if(checked[i].player_id >= 0 && is_vacant(checked[i].player_id)) {checked[i].player_id = -1;}
+        }
+        batch = coalesce_updates(checked,this->reached_index,success);
+    }
+    if(batch.empty()) {return success;}
+
+    vector<player_data> old;
+    update_batch_helper(root_node,0,max_num_of_players-1,batch.data(),batch.data() + batch.size(),old);
+
+    for(size_t i = 0; i < batch.size(); i++){
+        indexes.replace(old[i],batch[i]);
+        external_changed(batch[i]);
+    }
+    return success;
+}
+
+// adds delta to the score of every player with an ID in [begin_id , end_id] in O(log n) : the O(log n) nodes
+// covering the range take delta as a pending tag and writes push it down on their way , ID queries add the
+// tags on their path instead , so they stay exact and read only
+// the finish_time , rank and combined indexes are not touched , the range is queued and the next write (or
+// sync_indexes) moves the shifted players , time , rank and external ID reads see the old
+// scores until then
+bool add_score_range(int begin_id, int end_id, int delta){
+
+    LB_OP_SCOPE(op_range_add);
+    if(refuse_if_frozen()) {return false;}
+    if(begin_id < 0 || end_id > this->reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return false;
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return false;
+    }
+
+    add_range_helper(root_node,0,max_num_of_players-1,begin_id,end_id,delta);
+    if(delta != 0){
+        score_shift shift = {begin_id,end_id,delta};
+        pending_shifts.push_back(shift);
+    }
+    return true;
+}
+
+// catches the finish_time , rank , combined and external ID indexes up with the range adds queued since the last
+// call , every write calls it first so the indexes are current whenever a write starts , readers on other threads
+// need the writer to call it before handing the board over
+// the queued ranges are merged into runs of one net delta and the players of every run are moved one by one ,
+// O(p log p + k log n) for p ranges over k players , once k reaches a quarter of the board the indexes are rebuilt
+void sync_indexes(){
+    if(pending_shifts.empty()) {return;}
+
+    vector<pair<int,int> > edges ; // (ID , change of the net delta from that ID on)
+    for(size_t i = 0; i < pending_shifts.size(); i++){
+        edges.push_back(make_pair(pending_shifts[i].begin_id,pending_shifts[i].delta));
+        edges.push_back(make_pair(pending_shifts[i].end_id + 1,-pending_shifts[i].delta));
+    }
+    pending_shifts.clear();
+    sort(edges.begin(),edges.end());
+
+    vector<score_shift> runs ;
+    long long shifted = 0;
+    int net = 0;
+    for(size_t i = 0; i < edges.size(); ){
+        int from = edges[i].first;
+        for(; i < edges.size() && edges[i].first == from; i++) {net += edges[i].second;}
+        if(net == 0 || i == edges.size()) {continue;}
+        score_shift run = {from,edges[i].first - 1,net};
+        runs.push_back(run);
+        shifted += run.end_id - run.begin_id + 1;
+    }
+
+    if(shifted * 4 >= this->reached_index + 1){
+        vector<player_data> current = players();
+        indexes.reset(max_num_of_players,current);
+        if(external_ids.size() == 0) {return;}
+        for(size_t r = 0; r < runs.size(); r++){
+            for(int id = runs[r].begin_id; id <= runs[r].end_id; id++) {external_changed(current[id]);}
+        }
+        return;
+    }
+    for(size_t r = 0; r < runs.size(); r++){
+        for(int id = runs[r].begin_id; id <= runs[r].end_id; id++){
+            player_data now = query_by_index_helper(root_node,0,max_num_of_players-1,id,id);
+            if(now.player_id == -1) {continue;} // removed slot
+            player_data before = now;
+            before.score -= runs[r].delta;
+            indexes.replace(before,now);
+            external_changed(now);
+        }
+    }
+}
+
+// false while a range add is queued for the indexes , see sync_indexes
+bool indexes_current() const {
+    return pending_shifts.empty();
+}
+
+// removes a player in O(log n) : the leaf becomes the empty player , the ancestors are recomputed and the player
+// leaves every index , the slot goes on a free list and the next insert_into_tree takes it
+// IDs are not handed out in order any more once slots are reused , the last slot freed is reused first
+bool remove_player(int player_id){
+
+    LB_OP_SCOPE(op_remove);
+    if(refuse_if_frozen()) {return false;}
+    sync_indexes();
+    if(player_id < 0 || player_id > this->reached_index || is_vacant(player_id)){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    player_data old = query_by_index_helper(root_node,0,max_num_of_players-1,player_id,player_id);
+    remove_helper(root_node,0,max_num_of_players-1,player_id);
+    indexes.remove(old);
+
+    if((int)vacant.size() <= player_id) {vacant.resize(this->reached_index + 1,false);}
+    vacant[player_id] = true;
+    free_ids.push_back(player_id);
+
+    if(has_external_id(player_id)){
+        external_ids.erase(external_of[player_id]);
+        external_order.erase(external_of[player_id]);
+    }
+    return true;
+}
+
+// hands the nodes of every subtree that holds removed slots only back to the pool , O(nodes)
+// returns the number of nodes reclaimed , queries and reused slots work the same afterwards
+int compact(){
+    int released = 0;
+    if(frozen) {return released;}
+    compact_helper(root_node,released);
+    return released;
+}
+
+// players currently on the board , removed ones not counted
+int player_count() const {
+    return this->reached_index + 1 - (int)free_ids.size();
+}
+
+// insert_into_tree for a player known by an external account ID , the board keeps the mapping to its slot
+// returns the slot , or -1 if the external ID is already on the board or the player could not be placed
+int insert_with_external_id(long long external_id, player_data p){
+
+    LB_OP_SCOPE(op_insert);
+    if(refuse_if_frozen()) {return -1;}
+    if(external_ids.find(external_id) != -1){
+        cerr<<"Duplicate External ID"<<endl;
+        return -1;
+    }
+    int id = place_player(p);
+    if(id == -1) {return -1;}
+
+    external_ids.insert(external_id,id);
+    if((int)external_of.size() <= id) {external_of.resize(max(2*external_of.size(),(size_t)id + 1));}
+    external_of[id] = external_id;
+    external_order.insert(external_id,player_data(p.score,id,p.finish_time));
+    return id;
+}
+
+// slot of an external ID , -1 if it is not on the board , one probe of the flat map
+int slot_of_external_id(long long external_id) const {
+    return external_ids.find(external_id);
+}
+
+// update_player_data addressed by external ID : one probe , then the O(log n) tree walk
+bool update_by_external_id(long long external_id, int score, int finish_time){
+    int id = external_ids.find(external_id);
+    if(id == -1){
+        cerr<<"Invalid External ID"<<endl;
+        return false;
+    }
+    return update_player_data(player_data(score,id,finish_time));
+}
+
+// best player whose external ID is in [begin_external_id , end_external_id] , O(log n) on the external ID order ,
+// whatever slots the accounts got , neither end needs to be on the board
+// like the time reads it sees range adds once the indexes are caught up (sync_indexes)
+player_data query_by_external_id_range(long long begin_external_id, long long end_external_id) const {
+    LB_OP_SCOPE(op_query_by_id);
+    if(begin_external_id > end_external_id){
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+    return external_order.query(begin_external_id,end_external_id);
+}
+
+int size() const {
+    return max_num_of_players;
+}
+
+int last_index() const {
+    return reached_index;
+}
+
+// every slot up to last_index in ID order , one walk over the leaves in O(n) , removed slots are the empty player
+vector<player_data> players() const {
+    if(frozen) {return frozen->by_id();}
+    vector<player_data> out;
+    out.reserve(this->reached_index + 1);
+    collect_leaves(root_node,0,max_num_of_players-1,out);
+    return out;
+}
+
+// read mostly mode : the ID tree is replaced by a sparse_table , ID queries become two array lookups
+// a board with aggregates keeps them per ID block next to it , query_range stays O(log n)
+// the finish_time and rank indexes stay , inserts and updates are refused until thaw
+void freeze(){
+    if(frozen) {return;}
+    sync_indexes();
+    frozen = new sparse_table(players());
+    if(!is_empty<aggregate>::value){
+        const vector<player_data> &by_id = frozen->by_id();
+        int count = (int)by_id.size();
+        frozen_aggregates.assign(2*count,aggregate());
+        for(int i = 0; i < count; i++) {frozen_aggregates[count + i] = Agg::of(by_id[i]);}
+        for(int i = count - 1; i >= 1; i--) {frozen_aggregates[i] = Agg::combine(frozen_aggregates[2*i],frozen_aggregates[2*i+1]);}
+    }
+    pool.clear();
+    root_node = 0;
+}
+
+// rebuilds the ID tree from the frozen players in O(n) , the board takes updates again
+void thaw(){
+    if(!frozen) {return;}
+    const vector<player_data> &by_id = frozen->by_id();
+    if(!by_id.empty()){
+        pool.reserve(2*(int)by_id.size() + 64);
+        root_node = build_helper(0,max_num_of_players-1,by_id.data(),(int)by_id.size());
+        for(size_t i = 0; i < free_ids.size(); i++) {remove_helper(root_node,0,max_num_of_players-1,free_ids[i]);}
+    }
+    delete frozen;
+    frozen = 0;
+    vector<aggregate>().swap(frozen_aggregates);
+}
+
+bool is_frozen() const {
+    return frozen != 0;
+}
+
+// bytes held by the frozen form , 0 when the board is not frozen
+size_t frozen_memory_bytes() const {
+    return frozen ? frozen->memory_bytes() + frozen_aggregates.capacity() * sizeof(aggregate) : 0;
+}
+
+#ifdef LEADERBOARD_STATS
+// copy of the counters , safe to keep while the tree goes on
+tree_stats stats_snapshot() const {
+    return stats.snapshot();
+}
+
+void reset_stats(){
+    stats.reset();
+}
+
+void export_stats(ostream &out) const {
+    stats.snapshot().export_csv(out);
+}
+#endif
+
+};
+
+typedef basic_segment_tree<no_aggregates> segment_tree;
+
+// same public interface as segment_tree , but the nodes live in one contiguous array laid out as an implicit heap :
+// node i has children 2i and 2i+1 , the leaves start at index capacity , so the ID tree has no pointers to chase
+// and no per node allocation , the finish_time and rank indexes are the same treaps segment_tree uses , an insert
+// takes their two nodes from the indexes' pools and every insert or update walks them recursively
+// every node holds the ranking_key of its best player , so combining two children is one max without branches
+class flat_segment_tree {
+
+private:
+
+vector<ranking_key> nodes ;
+int capacity ; // number of leaves , max_num_of_players rounded up to a power of two
+int max_num_of_players;
+int reached_index ;
+secondary_indexes indexes ;
+
+// walks from a leaf up to the root , recomputing every ancestor
+void set_leaf(int index, player_data data){
+
+    int i = index + capacity;
+    nodes[i] = pack_player(data);
+
+    for(i >>= 1; i >= 1; i >>= 1){
+        nodes[i] = max(nodes[2*i],nodes[2*i+1]);
+    }
+}
+
+public:
+
+flat_segment_tree(int size) :
+capacity(1),max_num_of_players(size),reached_index(-1)
+{
+    while(capacity < size) {capacity <<= 1;}
+    nodes.assign(2*capacity,0);
+}
+
+void insert_into_tree(player_data p){
+
+    if(this->reached_index + 1 >= max_num_of_players){
+        cerr<<"Leaderboard is full"<<endl;
+        return;
+    }
+
+    this->reached_index++;
+    player_data p1(p.score,this->reached_index,p.finish_time);
+    indexes.add(p1);
+    set_leaf(this->reached_index,p1);
+}
+
+// leaves are written directly and the internal nodes are filled in one pass from the bottom , O(n)
+// a non empty tree gets the new leaves written the same way and only their ancestors recomputed , level by level
+void build_from(const player_data* players, int count){
+
+    if(count > max_num_of_players - 1 - this->reached_index){
+        cerr<<"Leaderboard is full"<<endl;
+        count = max_num_of_players - 1 - this->reached_index;
+    }
+    if(count <= 0) {return;}
+
+    if(this->reached_index != -1){
+        int first = this->reached_index + 1;
+        vector<player_data> indexed(count);
+        for(int i = 0; i < count; i++){
+            indexed[i] = player_data(players[i].score,first + i,players[i].finish_time);
+            nodes[first + i + capacity] = pack_player(indexed[i]);
+        }
+        indexes.build_from(indexed);
+        for(int low = (first + capacity) >> 1, high = (first + count - 1 + capacity) >> 1; low >= 1; low >>= 1, high >>= 1){
+            for(int i = low; i <= high; i++) {nodes[i] = max(nodes[2*i],nodes[2*i+1]);}
+        }
+        this->reached_index += count;
+        return;
+    }
+
+    vector<player_data> indexed(count);
+    for(int i = 0; i < count; i++){
+        indexed[i] = player_data(players[i].score,i,players[i].finish_time);
+        nodes[i + capacity] = pack_player(indexed[i]);
+    }
+    for(int i = capacity - 1; i >= 1; i--){
+        nodes[i] = max(nodes[2*i],nodes[2*i+1]);
+    }
+    this->reached_index = count - 1;
+    indexes.build_from(indexed);
+}
+
+player_data query_the_tree_by_time(int start_time, int finish_time){
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+    return indexes.times.query(start_time,finish_time);
+}
+
+player_data query_the_tree_by_id(int begin_id, int end_id){
+
+    if(begin_id < 0 || end_id > this->reached_index){
+
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+
+    // bottom up over the half open range [l , r) , taking a node whenever the range boundary cuts its parent
+    ranking_key best = 0;
+    int l = begin_id + capacity;
+    int r = end_id + capacity + 1;
+
+    for(; l < r; l >>= 1, r >>= 1){
+        if(l & 1) {best = max(best,nodes[l++]);}
+        if(r & 1) {best = max(best,nodes[--r]);}
+    }
+    return unpack_player(best);
+}
+
+bool update_player_data(player_data new_player_data){
+
+    if(new_player_data.player_id < 0 || new_player_data.player_id > this->reached_index){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    player_data p1(new_player_data.score,new_player_data.player_id,new_player_data.finish_time);
+    indexes.replace(unpack_player(nodes[p1.player_id + capacity]),p1);
+    set_leaf(p1.player_id,p1);
+    return true;
+}
+
+struct heap_slot_order {
+    const vector<ranking_key>* nodes;
+    bool operator()(int a, int b) const {
+        return (*nodes)[a] < (*nodes)[b];
+    }
+};
+
+// the k best players of an ID range , best first search from the nodes of the bottom up cover
+vector<player_data> top_k_by_id(int begin_id, int end_id, int k){
+
+    vector<player_data> result;
+    if(begin_id < 0 || end_id > this->reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return result;
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return result;
+    }
+
+    heap_slot_order order;
+    order.nodes = &nodes;
+    priority_queue<int,vector<int>,heap_slot_order> heap(order);
+
+    int l = begin_id + capacity;
+    int r = end_id + capacity + 1;
+    for(; l < r; l >>= 1, r >>= 1){
+        if(l & 1) {heap.push(l++);}
+        if(r & 1) {heap.push(--r);}
+    }
+
+    while(!heap.empty() && (int)result.size() < k){
+        int i = heap.top();
+        heap.pop();
+
+        if(nodes[i] == 0) {continue;} // empty
+        if(i >= capacity){
+            result.push_back(unpack_player(nodes[i]));
+            continue;
+        }
+        heap.push(2*i);
+        heap.push(2*i+1);
+    }
+    return result;
+}
+
+vector<player_data> top_k_by_time(int start_time, int finish_time, int k){
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return vector<player_data>();
+    }
+    return indexes.times.top_k(start_time,finish_time,k);
+}
+
+// global rank of a player (1 is the best) under the best_player ordering , O(log n)
+int rank_of(int player_id){
+    if(player_id < 0 || player_id > this->reached_index){
+        cerr<<"Invalid Player ID"<<endl;
+        return -1;
+    }
+    return indexes.ranks.rank_of(unpack_player(nodes[player_id + capacity]));
+}
+
+// the player holding a global rank (1 is the best) , O(log n)
+player_data player_at(int rank){
+    if(rank < 1 || rank > this->reached_index + 1){
+        cerr<<"Invalid Rank"<<endl;
+        return player_data();
+    }
+    return indexes.ranks.player_at(rank);
+}
+
+// best player with an ID in [begin_id , end_id] who finished in [start_time , finish_time] , O(log^2 n)
+// the first call builds the two dimensional index from the leaves , later inserts and updates keep it current
+player_data query_by_id_and_time(int begin_id, int end_id, int start_time, int finish_time){
+
+    if(begin_id < 0 || end_id > this->reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+
+    if(!indexes.id_times) {indexes.enable_id_times(max_num_of_players,players());}
+    return indexes.id_times->query(begin_id,end_id,start_time,finish_time);
+}
+
+// writes all leaves first , then recomputes the dirty nodes one level at a time so each is visited once
+vector<bool> apply_updates(const vector<player_data> &updates){
+
+    vector<bool> success;
+    vector<player_data> batch = coalesce_updates(updates,this->reached_index,success);
+
+    vector<int> dirty;
+    for(size_t i = 0; i < batch.size(); i++){
+        int leaf = batch[i].player_id + capacity;
+        indexes.replace(unpack_player(nodes[leaf]),batch[i]);
+        nodes[leaf] = pack_player(batch[i]);
+        dirty.push_back(leaf);
+    }
+
+    // dirty stays sorted , so the parents of a level are deduplicated by comparing neighbours
+    while(!dirty.empty() && dirty[0] > 1){
+        size_t count = 0;
+        for(size_t i = 0; i < dirty.size(); i++){
+            int parent = dirty[i] >> 1;
+            if(count == 0 || dirty[count-1] != parent) {dirty[count++] = parent;}
+        }
+        dirty.resize(count);
+
+        for(size_t i = 0; i < dirty.size(); i++){
+            int j = dirty[i];
+            nodes[j] = max(nodes[2*j],nodes[2*j+1]);
+        }
+    }
+    return success;
+}
+
+int size() const {
+    return max_num_of_players;
+}
+
+int last_index() const {
+    return reached_index;
+}
+
+// every inserted player in ID order , the used leaves unpacked
+vector<player_data> players() const {
+    vector<player_data> result(this->reached_index + 1);
+    for(int i = 0; i <= this->reached_index; i++) {result[i] = unpack_player(nodes[capacity + i]);}
+    return result;
 }
 
 };
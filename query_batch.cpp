@@ -0,0 +1,107 @@
+#pragma once
+#include "project.cpp"
+#include "thread_pool.cpp"
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+enum range_kind { by_id, by_time };
+
+// one range query of a batch , [low , high] is an ID range or a finish_time range
+struct range_query {
+    range_kind kind;
+    int low;
+    int high;
+
+    range_query(range_kind k = by_id, int l = 0, int h = 0) : kind(k),low(l),high(h) {}
+};
+
+// queries per task , small enough for idle workers to steal a fair share of a burst ,
+// big enough that a task is not mostly scheduling overhead
+const int query_batch_chunk = 64;
+
+// answers every query of the batch on the pool , results[i] belongs to queries[i]
+// the tree must not change while the batch runs , any tree with the two range queries works
+// (segment_tree , flat_segment_tree , or concurrent_leaderboard which stays stable for readers by itself)
+// a segment_tree with queued range adds needs sync_indexes first , the pool threads only read
+// a -DLEADERBOARD_STATS build counts the reads of every pool thread , the counters are added atomically
+template <class Tree>
+vector<player_data> query_batch(thread_pool &pool, Tree &tree, const vector<range_query> &queries){
+
+    vector<player_data> results(queries.size());
+    int chunks = (int)((queries.size() + query_batch_chunk - 1) / query_batch_chunk);
+
+    pool.parallel_for(chunks,[&](int c){
+        size_t first = (size_t)c * query_batch_chunk;
+        size_t last = min(queries.size(),first + query_batch_chunk);
+        for(size_t i = first; i < last; i++){
+            const range_query &q = queries[i];
+            results[i] = q.kind == by_id ? tree.query_the_tree_by_id(q.low,q.high)
+                                         : tree.query_the_tree_by_time(q.low,q.high);
+        }
+    });
+    return results;
+}
+
+// best player of every position range [first , last] over values , in one sweep over the positions
+// ranges are visited by last , a stack keeps the positions that beat every position after them , so the best of
+// [first , last] is the first stack entry at or after first , O((n + q) log n) with O(n) extra memory
+inline vector<player_data> sweep_range_best(const vector<player_data> &values, const vector<pair<int,int> > &ranges){
+
+    vector<player_data> results(ranges.size());
+    vector<int> order;
+    for(size_t i = 0; i < ranges.size(); i++){
+        if(ranges[i].first <= ranges[i].second) {order.push_back((int)i);}
+    }
+    sort(order.begin(),order.end(),[&](int a, int b){ return ranges[a].second < ranges[b].second; });
+
+    vector<int> stack;
+    int next = 0;
+    for(size_t q = 0; q < order.size(); q++){
+        const pair<int,int> &range = ranges[order[q]];
+        for(; next <= range.second; next++){
+            while(!stack.empty() && player_data :: ranks_higher(values[next],values[stack.back()])) {stack.pop_back();}
+            stack.push_back(next);
+        }
+        results[order[q]] = values[*lower_bound(stack.begin(),stack.end(),range.first)];
+    }
+    return results;
+}
+
+// answers a whole batch against a frozen tree offline : ID ranges on the players in ID order , time ranges on the
+// players sorted by finish_time , where a time window is one contiguous run , each kind in a single sweep
+// answers and error messages match query_the_tree_by_id / query_the_tree_by_time , results[i] belongs to queries[i]
+template <class Tree>
+vector<player_data> offline_query_batch(Tree &tree, const vector<range_query> &queries){
+
+    vector<player_data> by_id_order = tree.players();
+    vector<player_data> by_time_order = by_id_order;
+    sort(by_time_order.begin(),by_time_order.end(),finish_time_order());
+    int last_index = (int)by_id_order.size() - 1;
+
+    vector<pair<int,int> > id_ranges(queries.size(),make_pair(1,0)), time_ranges(queries.size(),make_pair(1,0));
+    for(size_t i = 0; i < queries.size(); i++){
+        const range_query &q = queries[i];
+        if(q.kind == by_id){
+            if(q.low < 0 || q.high > last_index) {cerr<<"Invalid ID "<<endl;}
+            else if(q.low > q.high) {cerr<<"Invalid Interval"<<endl;}
+            else {id_ranges[i] = make_pair(q.low,q.high);}
+        }
+        else if(q.low < 0 || q.high < 0) {cerr<<"Wrong Interval";}
+        else {
+            // the run of players with finish_time in [low , high]
+            int first = (int)(lower_bound(by_time_order.begin(),by_time_order.end(),q.low,
+                              [](const player_data &p, int t){ return p.finish_time < t; }) - by_time_order.begin());
+            int last = (int)(upper_bound(by_time_order.begin(),by_time_order.end(),q.high,
+                             [](int t, const player_data &p){ return t < p.finish_time; }) - by_time_order.begin()) - 1;
+            time_ranges[i] = make_pair(first,last);
+        }
+    }
+
+    vector<player_data> results = sweep_range_best(by_id_order,id_ranges);
+    vector<player_data> time_results = sweep_range_best(by_time_order,time_ranges);
+    for(size_t i = 0; i < queries.size(); i++){
+        if(queries[i].kind == by_time) {results[i] = time_results[i];}
+    }
+    return results;
+}
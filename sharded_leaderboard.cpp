@@ -0,0 +1,141 @@
+#pragma once
+#include "project.cpp"
+#include "thread_pool.cpp"
+#include <atomic>
+#include <mutex>
+
+// leaderboard split over independent segment_tree shards , each behind its own lock
+// player g lives in shard g % N as local player g / N , so inserts rotate over the shards and any ID range
+// is one contiguous local range per shard , updates to different shards run in parallel
+// cross shard queries ask every shard on the thread pool and merge the answers with best_player
+class sharded_leaderboard {
+
+private:
+
+int max_num_of_players;
+int num_shards;
+vector<segment_tree*> shards ;
+vector<mutex*> shard_locks ;
+mutex insert_lock ;              // ids are handed out in order , like reached_index in one tree
+atomic<int> reached_index ;
+thread_pool pool ;
+
+player_data to_global(player_data p, int shard){
+    if(p.player_id >= 0) {p.player_id = p.player_id * num_shards + shard;}
+    return p;
+}
+
+player_data to_local(player_data p){
+    p.player_id /= num_shards;
+    return p;
+}
+
+// best answer over all shards , body answers for one shard while holding its lock
+player_data merge_shards(const function<player_data(int)> &body){
+    vector<player_data> answers(num_shards);
+
+    pool.parallel_for(num_shards,[&](int s){
+        lock_guard<mutex> lock(*shard_locks[s]);
+        answers[s] = to_global(body(s),s);
+    });
+
+    player_data best ;
+    for(int s = 0; s < num_shards; s++){
+        best = player_data :: best_player(best,answers[s]);
+    }
+    return best;
+}
+
+public:
+
+sharded_leaderboard(int size, int shard_count) :
+max_num_of_players(size),num_shards(shard_count < 1 ? 1 : shard_count),reached_index(-1),pool(num_shards)
+{
+    int per_shard = (size + num_shards - 1) / num_shards;
+    for(int s = 0; s < num_shards; s++){
+        shards.push_back(new segment_tree(per_shard));
+        shard_locks.push_back(new mutex());
+    }
+}
+
+~sharded_leaderboard(){
+    for(int s = 0; s < num_shards; s++){
+        delete shards[s];
+        delete shard_locks[s];
+    }
+}
+
+sharded_leaderboard(const sharded_leaderboard &) = delete;
+sharded_leaderboard& operator=(const sharded_leaderboard &) = delete;
+
+// inserts are serialized so every shard sees its local ids in order
+void insert_into_tree(player_data p){
+
+    lock_guard<mutex> order(insert_lock);
+    int id = reached_index.load() + 1;
+    if(id >= max_num_of_players){
+        cerr<<"Leaderboard is full"<<endl;
+        return;
+    }
+
+    int s = id % num_shards;
+    {
+        lock_guard<mutex> lock(*shard_locks[s]);
+        shards[s]->insert_into_tree(p);
+    }
+    reached_index.store(id);
+}
+
+// only the shard owning the player is locked
+bool update_player_data(player_data new_player_data){
+
+    int id = new_player_data.player_id;
+    if(id < 0 || id > reached_index.load()){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    int s = id % num_shards;
+    lock_guard<mutex> lock(*shard_locks[s]);
+    return shards[s]->update_player_data(to_local(new_player_data));
+}
+
+player_data query_the_tree_by_id(int begin_id, int end_id){
+
+    if(begin_id < 0 || end_id > reached_index.load()){
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+
+    return merge_shards([&](int s){
+        // local ids of shard s inside [begin_id , end_id]
+        int first = (begin_id - s + num_shards - 1) / num_shards;
+        int last = end_id < s ? -1 : (end_id - s) / num_shards;
+        if(first > last) {return player_data();}
+        return shards[s]->query_the_tree_by_id(first,last);
+    });
+}
+
+player_data query_the_tree_by_time(int start_time, int finish_time){
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+
+    return merge_shards([&](int s){
+        return shards[s]->query_the_tree_by_time(start_time,finish_time);
+    });
+}
+
+// best player of the whole board
+player_data global_best(){
+    int last = reached_index.load();
+    if(last < 0) {return player_data();}
+    return query_the_tree_by_id(0,last);
+}
+
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include "project.cpp"
+#include <climits>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+using namespace std;
+
+// "best in the last W time units" board : players are bucketed by finish_time , a bucket covers bucket_width
+// time units and holds its players in a rank_index , the buckets of the window sit in a ring
+// a small implicit heap over the ring keeps the best of every bucket , so the window best is its root
+// when the window moves past a bucket the whole bucket is freed at once , each player is freed exactly once ,
+// and memory only ever holds the players of the live buckets
+//
+// the window is rounded to whole buckets : a player leaves when its whole bucket is older than now - window + 1 ,
+// bucket_width 1 gives an exact window
+class sliding_window_leaderboard {
+
+private:
+
+struct bucket {
+    long long index ;     // finish_time / bucket_width , -1 when the slot is unused
+    rank_index players ;
+    unordered_set<int> ids ; // ids of the players in this bucket , a player leaves it when it moves on
+
+    bucket() : index(-1) {}
+};
+
+int window ;
+int bucket_width ;
+int slot_count ;               // enough buckets for a whole window plus the one being filled
+int heap_leaves ;              // slot_count rounded up to a power of two
+vector<bucket*> slots ;        // bucket i lives in slot i % slot_count
+vector<player_data> heap ;     // implicit heap , leaf s holds the best player of slot s
+unordered_map<int,player_data> live ; // id -> current data , only for players of live buckets
+long long now ;
+long long oldest ;             // index of the oldest bucket that can still be live
+int reached_index ;
+
+int slot_of(long long index) const {
+    return (int)(index % slot_count);
+}
+
+void refresh(int slot){
+    bucket* b = slots[slot];
+    int i = slot + heap_leaves;
+    heap[i] = b->players.size() ? b->players.player_at(1) : player_data();
+    for(i >>= 1; i >= 1; i >>= 1){
+        heap[i] = player_data :: best_player(heap[2*i],heap[2*i+1]);
+    }
+}
+
+void expire(int slot){
+    bucket* b = slots[slot];
+    for(unordered_set<int>::iterator id = b->ids.begin(); id != b->ids.end(); ++id) {live.erase(*id);}
+    delete b;
+    slots[slot] = new bucket();
+    refresh(slot);
+}
+
+// the bucket for a finish_time inside the window , reusing the slot of the bucket it replaces
+bucket* bucket_for(int finish_time){
+    long long index = finish_time / bucket_width;
+    int slot = slot_of(index);
+    if(slots[slot]->index != index){
+        if(slots[slot]->index != -1) {expire(slot);}
+        slots[slot]->index = index;
+    }
+    return slots[slot];
+}
+
+void place(const player_data &p){
+    bucket* b = bucket_for(p.finish_time);
+    b->players.insert(p);
+    b->ids.insert(p.player_id);
+    live[p.player_id] = p;
+    refresh(slot_of(b->index));
+}
+
+public:
+
+sliding_window_leaderboard(int window, int bucket_width) :
+window(window < 1 ? 1 : window),bucket_width(bucket_width < 1 ? 1 : bucket_width),now(0),oldest(0),reached_index(-1)
+{
+    slot_count = (this->window + this->bucket_width - 1) / this->bucket_width + 1;
+    heap_leaves = 1;
+    while(heap_leaves < slot_count) {heap_leaves <<= 1;}
+    heap.assign(2*heap_leaves,player_data());
+    for(int i = 0; i < slot_count; i++) {slots.push_back(new bucket());}
+}
+
+~sliding_window_leaderboard(){
+    for(size_t i = 0; i < slots.size(); i++) {delete slots[i];}
+}
+
+sliding_window_leaderboard(const sliding_window_leaderboard &) = delete;
+sliding_window_leaderboard& operator=(const sliding_window_leaderboard &) = delete;
+
+// moves the window so it ends at time , every bucket that fell out is freed , time never goes back
+void advance(int time){
+    if(time <= now) {return;}
+    now = time;
+
+    long long first_live = window_start() / bucket_width;
+    // a jump longer than the ring only needs every slot checked once
+    if(first_live - oldest > slot_count) {oldest = first_live - slot_count;}
+    for(; oldest < first_live; oldest++){
+        int slot = slot_of(oldest);
+        if(slots[slot]->index != -1 && slots[slot]->index < first_live) {expire(slot);}
+    }
+}
+
+// first finish_time still inside the window , rounded down to its bucket
+int window_start() const {
+    long long start = now - window + 1;
+    if(start < 0) {start = 0;}
+    return (int)(start / bucket_width * bucket_width);
+}
+
+// the player gets the next ID , like insert_into_tree of the trees , a finish_time past now moves the window
+// a player already older than the window is refused
+void insert_into_tree(player_data p){
+    if(p.finish_time < 0){
+        cerr<<"Wrong Interval";
+        return;
+    }
+    advance(p.finish_time);
+    if(p.finish_time < window_start()){
+        cerr<<"Expired Player"<<endl;
+        return;
+    }
+    this->reached_index++;
+    place(player_data(p.score,this->reached_index,p.finish_time));
+}
+
+// only players still in the window can be updated , a finish_time older than the window drops the player
+bool update_player_data(player_data new_player_data){
+    unordered_map<int,player_data>::iterator it = live.find(new_player_data.player_id);
+    if(it == live.end() || new_player_data.finish_time < 0){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    player_data old_data = it->second;
+    int slot = slot_of(old_data.finish_time / bucket_width);
+    slots[slot]->players.erase(old_data);
+    slots[slot]->ids.erase(old_data.player_id);
+    refresh(slot);
+    live.erase(it);
+
+    advance(new_player_data.finish_time);
+    if(new_player_data.finish_time >= window_start()) {place(new_player_data);}
+    return true;
+}
+
+// best player of the window , O(1)
+player_data best() const {
+    return heap[1];
+}
+
+// the k best players of the window , best first
+// buckets are merged through a heap holding the next candidate of every bucket , O((buckets + k) log n)
+vector<player_data> top_k(int k){
+    struct candidate {
+        player_data value;
+        int slot;
+        int rank;
+    };
+    struct candidate_order {
+        bool operator()(const candidate &a, const candidate &b) const {
+            return player_data :: ranks_higher(b.value,a.value);
+        }
+    };
+
+    vector<player_data> result;
+    priority_queue<candidate,vector<candidate>,candidate_order> candidates;
+    for(int s = 0; s < slot_count; s++){
+        if(slots[s]->players.size()){
+            candidate c = {slots[s]->players.player_at(1),s,1};
+            candidates.push(c);
+        }
+    }
+
+    while(!candidates.empty() && (int)result.size() < k){
+        candidate c = candidates.top();
+        candidates.pop();
+        result.push_back(c.value);
+        if(c.rank < slots[c.slot]->players.size()){
+            candidate next = {slots[c.slot]->players.player_at(c.rank + 1),c.slot,c.rank + 1};
+            candidates.push(next);
+        }
+    }
+    return result;
+}
+
+// players currently inside the window
+int size() const {
+    return (int)live.size();
+}
+
+int last_index() const {
+    return reached_index;
+}
+
+// entries held by the buckets , one per live player however often players are updated
+int bucket_entries() const {
+    int entries = 0;
+    for(int s = 0; s < slot_count; s++) {entries += (int)slots[s]->ids.size();}
+    return entries;
+}
+
+};
@@ -0,0 +1,217 @@
+#pragma once
+#include "project.cpp"
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+// streaming loader for (score , finish_time) dumps , rows are parsed in fixed size chunks and every chunk goes
+// into the tree with one build_from , memory stays at one chunk buffer plus one row batch whatever the file size
+//
+// csv    : one "score,finish_time" row per line , '\r' and blank lines are ignored , a row that does not parse
+//          (a header line for example) is counted in bad_rows and skipped
+// binary : back to back pairs of host order int32 , score then finish_time
+
+enum ingest_format { ingest_csv, ingest_binary };
+
+struct ingest_stats {
+    long long rows ;       // rows handed to the tree
+    long long bad_rows ;
+    long long bytes ;
+    double seconds ;
+
+    ingest_stats() : rows(0),bad_rows(0),bytes(0),seconds(0) {}
+
+    double rows_per_sec() const {
+        return seconds > 0 ? rows / seconds : 0;
+    }
+};
+
+// rows per build_from call , the batch vector is allocated once and reused
+const int ingest_batch_rows = 1 << 16;
+const size_t ingest_chunk_bytes = 1 << 20;
+
+// base 10 integer with an optional '-' , no locale , no allocation , false on no digits or int overflow
+inline bool ingest_parse_int(const char* &p, const char* end, int &out){
+    bool negative = p < end && *p == '-';
+    if(negative) {p++;}
+    if(p == end || *p < '0' || *p > '9') {return false;}
+
+    long long value = 0;
+    while(p < end && *p >= '0' && *p <= '9'){
+        value = value * 10 + (*p - '0');
+        if(value > (long long)INT_MAX + 1) {return false;}
+        p++;
+    }
+    if(negative) {value = -value;}
+    if(value > INT_MAX || value < INT_MIN) {return false;}
+    out = (int)value;
+    return true;
+}
+
+template <class Tree>
+class ingest_sink {
+
+private:
+
+Tree &tree ;
+vector<player_data> batch ;
+
+public:
+
+ingest_stats stats ;
+
+ingest_sink(Tree &tree) : tree(tree)
+{
+    batch.reserve(ingest_batch_rows);
+}
+
+void push(int score, int finish_time){
+    batch.push_back(player_data(score,-1,finish_time));
+    if((int)batch.size() == ingest_batch_rows) {flush();}
+}
+
+void flush(){
+    if(batch.empty()) {return;}
+    tree.build_from(batch.data(),(int)batch.size());
+    stats.rows += batch.size();
+    batch.clear();
+}
+
+// parses the whole lines of [begin , end) , returns where the unfinished last line starts
+// with last_chunk the tail without a newline is a row too
+const char* csv_lines(const char* begin, const char* end, bool last_chunk){
+    const char* line = begin;
+    while(line < end){
+        const char* newline = (const char*)memchr(line,'\n',end - line);
+        if(!newline && !last_chunk) {return line;}
+        const char* line_end = newline ? newline : end;
+
+        const char* p = line;
+        const char* stop = line_end;
+        if(stop > p && stop[-1] == '\r') {stop--;}
+        if(p != stop){
+            int score, finish_time;
+            if(ingest_parse_int(p,stop,score) && p < stop && *p++ == ',' &&
+               ingest_parse_int(p,stop,finish_time) && p == stop){
+                push(score,finish_time);
+            }
+            else {stats.bad_rows++;}
+        }
+        line = newline ? newline + 1 : end;
+    }
+    return end;
+}
+
+// whole records of [begin , end) , returns where the unfinished last record starts
+const char* binary_rows(const char* begin, const char* end){
+    const size_t row = 2 * sizeof(int);
+    for(; (size_t)(end - begin) >= row; begin += row){
+        int pair[2];
+        memcpy(pair,begin,row); // the buffer may not be aligned for int
+        push(pair[0],pair[1]);
+    }
+    return begin;
+}
+
+};
+
+// reads fd to the end with read() in chunks of chunk_bytes , works for pipes and sockets as well as files
+template <class Tree>
+ingest_stats ingest_fd(Tree &tree, int fd, ingest_format format, size_t chunk_bytes = ingest_chunk_bytes){
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ingest_sink<Tree> sink(tree);
+    vector<char> buffer(chunk_bytes);
+    size_t carried = 0; // unfinished row moved to the front of the buffer
+
+    while(true){
+        if(carried == buffer.size()){
+            // one row longer than the whole chunk , no valid row is that long
+            sink.stats.bad_rows++;
+            carried = 0;
+        }
+
+        ssize_t got = ::read(fd,buffer.data() + carried,buffer.size() - carried);
+        if(got < 0){
+            cerr<<"Cannot read input"<<endl;
+            break;
+        }
+        sink.stats.bytes += got;
+        const char* begin = buffer.data();
+        const char* end = begin + carried + got;
+
+        const char* rest = format == ingest_csv ? sink.csv_lines(begin,end,got == 0) : sink.binary_rows(begin,end);
+        carried = end - rest;
+        memmove(buffer.data(),rest,carried);
+        if(got == 0) {break;}
+    }
+    if(format == ingest_binary && carried > 0) {sink.stats.bad_rows++;} // truncated last record
+
+    sink.flush();
+    sink.stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return sink.stats;
+}
+
+// maps the file and parses it in place , there is no copy into a read buffer
+// pages are released once parsed , so a file larger than RAM only ever keeps about one window resident
+template <class Tree>
+ingest_stats ingest_mapped(Tree &tree, const string &path, ingest_format format){
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ingest_sink<Tree> sink(tree);
+
+    int fd = open(path.c_str(),O_RDONLY);
+    if(fd < 0){
+        cerr<<"Cannot open input "<<path<<endl;
+        return sink.stats;
+    }
+    struct stat info;
+    size_t length = fstat(fd,&info) == 0 ? (size_t)info.st_size : 0;
+    void* base = length ? mmap(0,length,PROT_READ,MAP_PRIVATE,fd,0) : MAP_FAILED;
+    ::close(fd);
+    if(base == MAP_FAILED){
+        if(length) {cerr<<"Cannot map input "<<path<<endl;}
+        return sink.stats;
+    }
+    madvise(base,length,MADV_SEQUENTIAL);
+
+    const char* data = (const char*)base;
+    const char* end = data + length;
+    const size_t window = 64 * ingest_chunk_bytes;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t released = 0;
+
+    const char* position = data;
+    while(position < end){
+        const char* window_end = (size_t)(end - position) > window ? position + window : end;
+        const char* rest = format == ingest_csv ? sink.csv_lines(position,window_end,window_end == end)
+                                                : sink.binary_rows(position,window_end);
+        if(rest == position && window_end != end){
+            // nothing whole in a full window , the row is longer than any valid one
+            sink.stats.bad_rows++;
+            rest = window_end;
+        }
+        if(window_end == end && rest != end) {sink.stats.bad_rows++; rest = end;} // truncated last record
+
+        // drop the pages already parsed , MADV_DONTNEED on a read only private mapping just refaults from the file
+        size_t done = (size_t)(rest - data) / page * page;
+        if(done > released){
+            madvise((char*)base + released,done - released,MADV_DONTNEED);
+            released = done;
+        }
+        position = rest;
+    }
+    sink.stats.bytes = length;
+
+    sink.flush();
+    munmap(base,length);
+    sink.stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return sink.stats;
+}
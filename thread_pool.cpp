@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// fixed set of worker threads , every worker owns a deque of tasks
+// a worker pops its newest task from the back of its own deque and steals the oldest task from the front of
+// another deque when its own is empty , so a burst landing on one worker spreads over the idle ones
+class thread_pool {
+
+private:
+
+struct task_queue {
+    mutex m ;
+    deque<function<void()> > tasks ;
+};
+
+vector<unique_ptr<task_queue> > queues ;
+vector<thread> workers ;
+atomic<int> pending ;              // tasks sitting in any deque
+atomic<unsigned> next_queue ;      // round robin target for tasks submitted from outside the pool
+mutex sleep_mutex ;
+condition_variable wake ;
+bool stopping ;
+
+// which pool and which worker the current thread is , -1 for threads outside the pool
+static thread_pool*& current_pool(){
+    static thread_local thread_pool* pool = nullptr;
+    return pool;
+}
+static int& current_worker(){
+    static thread_local int worker = -1;
+    return worker;
+}
+
+int own_queue() const {
+    return current_pool() == this ? current_worker() : -1;
+}
+
+bool pop_back(int q, function<void()> &task){
+    lock_guard<mutex> lock(queues[q]->m);
+    if(queues[q]->tasks.empty()) {return false;}
+    task = move(queues[q]->tasks.back());
+    queues[q]->tasks.pop_back();
+    return true;
+}
+
+bool steal_front(int q, function<void()> &task){
+    lock_guard<mutex> lock(queues[q]->m);
+    if(queues[q]->tasks.empty()) {return false;}
+    task = move(queues[q]->tasks.front());
+    queues[q]->tasks.pop_front();
+    return true;
+}
+
+// own deque first , then every other deque starting right after it
+bool take_task(int self, function<void()> &task){
+    int n = (int)queues.size();
+    if(self >= 0 && pop_back(self,task)) {pending--; return true;}
+    int start = self >= 0 ? self + 1 : (int)(next_queue.load(memory_order_relaxed) % n);
+    for(int i = 0; i < n; i++){
+        int victim = (start + i) % n;
+        if(victim == self) {continue;}
+        if(steal_front(victim,task)) {pending--; return true;}
+    }
+    return false;
+}
+
+void worker_loop(int self){
+    current_pool() = this;
+    current_worker() = self;
+    while(true){
+        function<void()> task;
+        if(take_task(self,task)) {task(); continue;}
+
+        unique_lock<mutex> lock(sleep_mutex);
+        wake.wait(lock,[this]{ return stopping || pending.load() > 0; });
+        if(stopping && pending.load() == 0) {return;} // stopping and drained
+    }
+}
+
+public:
+
+// 0 workers means one per hardware thread
+thread_pool(int num_workers = 0) : pending(0),next_queue(0),stopping(false)
+{
+    if(num_workers <= 0) {num_workers = (int)thread::hardware_concurrency();}
+    if(num_workers <= 0) {num_workers = 1;}
+    for(int i = 0; i < num_workers; i++) {queues.push_back(unique_ptr<task_queue>(new task_queue()));}
+    for(int i = 0; i < num_workers; i++){
+        workers.push_back(thread([this,i]{ worker_loop(i); }));
+    }
+}
+
+~thread_pool(){
+    {
+        lock_guard<mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(size_t i = 0; i < workers.size(); i++) {workers[i].join();}
+}
+
+thread_pool(const thread_pool &) = delete;
+thread_pool& operator=(const thread_pool &) = delete;
+
+int size() const {
+    return (int)workers.size();
+}
+
+// a worker keeps its own tasks local , other threads deal tasks out round robin
+void submit(function<void()> task){
+    int q = own_queue();
+    if(q < 0) {q = (int)(next_queue.fetch_add(1,memory_order_relaxed) % queues.size());}
+    {
+        lock_guard<mutex> lock(queues[q]->m);
+        queues[q]->tasks.push_back(move(task));
+    }
+    pending++;
+    {
+        lock_guard<mutex> lock(sleep_mutex); // a worker between its predicate check and its wait must see pending
+    }
+    wake.notify_one();
+}
+
+// runs one waiting task on the calling thread , false when every deque is empty
+bool run_pending_task(){
+    function<void()> task;
+    if(!take_task(own_queue(),task)) {return false;}
+    task();
+    return true;
+}
+
+// runs body(0) ... body(count - 1) and returns when all of them are done
+// every index is its own task , the calling thread runs tasks too while it waits , so nested calls from a
+// worker never deadlock on a pool that is busy with its own caller
+void parallel_for(int count, const function<void(int)> &body){
+
+    if(count <= 0) {return;}
+    if(count == 1) {body(0); return;}
+
+    atomic<int> done(0);
+    for(int i = 0; i < count; i++){
+        submit([&body,&done,i]{
+            body(i);
+            done.fetch_add(1,memory_order_release);
+        });
+    }
+
+    while(done.load(memory_order_acquire) < count){
+        if(!run_pending_task()) {this_thread::yield();}
+    }
+}
+
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include "project.cpp"
+#include <unordered_set>
+
+// persistent leaderboard : every insert_into_tree and update_player_data creates a new version that shares all
+// unchanged subtrees with the previous one , so each version costs O(log n) nodes and stays queryable forever
+// version 0 is the empty board , version N is the board after the N-th insert or update
+class versioned_leaderboard {
+
+private:
+
+int max_num_of_players;
+unsigned seed ;
+vector<leaderboard_version> versions ;
+
+unsigned next_priority(){
+    // xorshift , same generator as ordered_index
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+bool valid_version(int version){
+    if(version < 0 || version >= (int)versions.size()){
+        cerr<<"Invalid Version"<<endl;
+        return false;
+    }
+    return true;
+}
+
+// versions share subtrees , a node seen once has had its whole subtree released already
+template <class Node>
+static void destroy(Node* node, unordered_set<Node*> &seen){
+    if(!node || !seen.insert(node).second) {return;}
+    destroy(node->left_ptr,seen);
+    destroy(node->right_ptr,seen);
+    delete node;
+}
+
+public:
+
+versioned_leaderboard(int size) :
+max_num_of_players(size),seed(2463534242u)
+{
+    leaderboard_version empty;
+    empty.id_root = 0;
+    empty.time_root = 0;
+    empty.reached_index = -1;
+    versions.push_back(empty);
+}
+
+~versioned_leaderboard(){
+    unordered_set<tree_node*> seen_tree;
+    unordered_set<index_node*> seen_index;
+    for(size_t i = 0; i < versions.size(); i++){
+        destroy(versions[i].id_root,seen_tree);
+        destroy(versions[i].time_root,seen_index);
+    }
+}
+
+versioned_leaderboard(const versioned_leaderboard &) = delete;
+versioned_leaderboard& operator=(const versioned_leaderboard &) = delete;
+
+// the newest version number
+int current_version(){
+    return (int)versions.size() - 1;
+}
+
+void insert_into_tree(player_data p){
+
+    leaderboard_version old = versions.back();
+    if(old.reached_index + 1 >= max_num_of_players){
+        cerr<<"Leaderboard is full"<<endl;
+        return;
+    }
+
+    // the replaced nodes belong to older versions , they stay alive
+    vector<tree_node*> shared_tree;
+    vector<index_node*> shared_index;
+
+    player_data p1(p.score,old.reached_index + 1,p.finish_time);
+    leaderboard_version next;
+    next.reached_index = p1.player_id;
+    next.id_root = path_copy_tree :: set_leaf(old.id_root,0,max_num_of_players-1,p1.player_id,p1,shared_tree);
+    next.time_root = time_index :: insert_copy(old.time_root,new index_node(p1,next_priority()),shared_index);
+    versions.push_back(next);
+}
+
+bool update_player_data(player_data new_player_data){
+
+    leaderboard_version old = versions.back();
+    if(new_player_data.player_id < 0 || new_player_data.player_id > old.reached_index){
+        cerr<<"Invalid Player ID"<<endl;
+        return false;
+    }
+
+    player_data p1(new_player_data.score,new_player_data.player_id,new_player_data.finish_time);
+    player_data before = path_copy_tree :: query(old.id_root,0,max_num_of_players-1,p1.player_id,p1.player_id);
+
+    vector<tree_node*> shared_tree;
+    vector<index_node*> shared_index;
+    vector<index_node*> between; // nodes of the erased but not yet inserted tree , no version keeps them
+
+    leaderboard_version next;
+    next.reached_index = old.reached_index;
+    next.id_root = path_copy_tree :: set_leaf(old.id_root,0,max_num_of_players-1,p1.player_id,p1,shared_tree);
+    index_node* erased = time_index :: erase_copy(old.time_root,before,shared_index,&between);
+
+    vector<index_node*> replaced;
+    next.time_root = time_index :: insert_copy(erased,new index_node(p1,next_priority()),replaced);
+
+    // the insert copied some of the erase's own nodes , those are unreachable from every version
+    sort(between.begin(),between.end());
+    for(size_t i = 0; i < replaced.size(); i++){
+        if(binary_search(between.begin(),between.end(),replaced[i])) {delete replaced[i];}
+    }
+
+    versions.push_back(next);
+    return true;
+}
+
+player_data query_the_tree_by_id(int begin_id, int end_id, int version){
+
+    if(!valid_version(version)) {return player_data();}
+    const leaderboard_version &v = versions[version];
+
+    if(begin_id < 0 || end_id > v.reached_index){
+        cerr<<"Invalid ID "<<endl;
+        return player_data();
+    }
+    else if (begin_id > end_id){
+        cerr<<"Invalid Interval"<<endl;
+        return player_data();
+    }
+    return path_copy_tree :: query(v.id_root,0,max_num_of_players-1,begin_id,end_id);
+}
+
+player_data query_the_tree_by_time(int start_time, int finish_time, int version){
+
+    if(!valid_version(version)) {return player_data();}
+    if(start_time < 0 || finish_time< 0 ){
+        cerr<<"Wrong Interval";
+        return player_data();
+    }
+    return time_index :: query_root(versions[version].time_root,start_time,finish_time);
+}
+
+// queries on the newest version
+player_data query_the_tree_by_id(int begin_id, int end_id){
+    return query_the_tree_by_id(begin_id,end_id,current_version());
+}
+
+player_data query_the_tree_by_time(int start_time, int finish_time){
+    return query_the_tree_by_time(start_time,finish_time,current_version());
+}
+
+};
@@ -0,0 +1,384 @@
+#pragma once
+#include "project.cpp"
+#include "leaderboard_snapshot.cpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+enum journal_op { journal_insert = 1, journal_update = 2, journal_remove = 3, journal_range_add = 4, journal_batch = 5 };
+
+// one mutation as it sits in the log , host byte order , the checksum covers the five fields before it
+// insert and update carry the player , remove its player_id , range_add the delta as score over the IDs
+// [player_id , finish_time] , batch the number of journal_update records right behind it as player_id
+// sequence numbers the mutations of the board , compaction does not reset it , the records of one batch share it
+struct journal_record {
+    int op;
+    int score;
+    int player_id;
+    int finish_time;
+    long long sequence;
+    unsigned checksum;
+    unsigned reserved; // keeps the record free of padding , always 0
+
+    journal_record(int op = 0, int score = 0, int player_id = 0, int finish_time = 0, long long sequence = 0) :
+    op(op),score(score),player_id(player_id),finish_time(finish_time),sequence(sequence),checksum(0),reserved(0)
+    {checksum = compute_checksum();}
+
+    unsigned compute_checksum() const {
+        // FNV-1a over the payload bytes
+        const unsigned char* bytes = (const unsigned char*)this;
+        unsigned h = 2166136261u;
+        for(size_t i = 0; i < 4 * sizeof(int) + sizeof(long long); i++) {h = (h ^ bytes[i]) * 16777619u;}
+        return h;
+    }
+};
+
+// append only log , mutations are buffered and a background thread writes and fdatasyncs them in groups
+// a group closes when it holds group_size records , when group_delay has passed since it opened , or on sync()
+// so one fsync is paid per group instead of per mutation
+class write_ahead_log {
+
+private:
+
+int fd ;
+int group_size ;
+chrono::milliseconds group_delay ;
+
+mutex m ;
+condition_variable group_ready ;     // wakes the flusher
+condition_variable group_durable ;   // wakes sync() callers
+vector<journal_record> buffer ;
+long long appended ;                 // records handed to append
+long long durable ;                  // records known to be on disk
+bool sync_requested ;
+bool stopping ;
+bool failed ;
+thread flusher ;
+
+void flush_loop(){
+    unique_lock<mutex> lock(m);
+    while(true){
+        group_ready.wait(lock,[this]{ return stopping || !buffer.empty(); });
+        if(buffer.empty()) {return;} // stopping and drained
+
+        // give the group a little time to fill , unless somebody is already waiting on it
+        group_ready.wait_for(lock,group_delay,[this]{
+            return stopping || sync_requested || (int)buffer.size() >= group_size;
+        });
+
+        vector<journal_record> group;
+        group.swap(buffer);
+        long long target = appended;
+        sync_requested = false;
+        lock.unlock();
+
+        bool ok = write_all((const char*)group.data(),group.size() * sizeof(journal_record)) && fdatasync(fd) == 0;
+
+        lock.lock();
+        if(!ok){
+            cerr<<"Cannot write journal"<<endl;
+            failed = true;
+        }
+        durable = target;
+        group_durable.notify_all();
+    }
+}
+
+bool write_all(const char* data, size_t size){
+    while(size > 0){
+        ssize_t written = ::write(fd,data,size);
+        if(written < 0) {return false;}
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+public:
+
+// appends to path , creating it if needed , records already in the file are left for read_all
+write_ahead_log(const string &path, int group_size = 1024, int group_delay_ms = 5) :
+fd(-1),group_size(group_size < 1 ? 1 : group_size),group_delay(group_delay_ms),
+appended(0),durable(0),sync_requested(false),stopping(false),failed(false)
+{
+    fd = open(path.c_str(),O_WRONLY | O_CREAT | O_APPEND,0644);
+    if(fd < 0){
+        cerr<<"Cannot open journal "<<path<<endl;
+        failed = true;
+        return;
+    }
+    flusher = thread([this]{ flush_loop(); });
+}
+
+// whatever is still buffered is written before the log closes
+~write_ahead_log(){
+    {
+        lock_guard<mutex> lock(m);
+        stopping = true;
+    }
+    group_ready.notify_all();
+    if(flusher.joinable()) {flusher.join();}
+    if(fd >= 0) {::close(fd);}
+}
+
+write_ahead_log(const write_ahead_log &) = delete;
+write_ahead_log& operator=(const write_ahead_log &) = delete;
+
+// the records stay next to each other and land in the same group , so a batch is written by one write call
+void append(const journal_record* records, size_t count){
+    bool full;
+    {
+        lock_guard<mutex> lock(m);
+        if(fd < 0) {return;}
+        buffer.insert(buffer.end(),records,records + count);
+        appended += (long long)count;
+        full = (int)buffer.size() >= group_size;
+    }
+    if(full) {group_ready.notify_one();}
+}
+
+// blocks until every record appended so far is on disk , false if a write failed
+bool sync(){
+    unique_lock<mutex> lock(m);
+    if(fd < 0) {return false;}
+    long long target = appended;
+    if(durable < target){
+        sync_requested = true;
+        group_ready.notify_one();
+        group_durable.wait(lock,[&]{ return durable >= target; });
+    }
+    return !failed;
+}
+
+// every intact record of the file at path , a torn or corrupt tail (crash in the middle of a write) is cut off
+// so later appends follow the last good record , a batch missing some of its records goes with the tail
+static vector<journal_record> read_all(const string &path){
+    vector<journal_record> records;
+    FILE* in = fopen(path.c_str(),"rb");
+    if(!in) {return records;}
+
+    journal_record r;
+    while(fread(&r,sizeof(r),1,in) == 1 && r.op >= journal_insert && r.op <= journal_batch &&
+          r.checksum == r.compute_checksum()){
+        records.push_back(r);
+    }
+    fclose(in);
+
+    for(size_t i = 0; i < records.size(); i++){
+        if(records[i].op != journal_batch) {continue;}
+        size_t end = i + 1 + (size_t)max(records[i].player_id,0);
+        bool whole = end <= records.size();
+        for(size_t j = i + 1; whole && j < end; j++){
+            whole = records[j].op == journal_update && records[j].sequence == records[i].sequence;
+        }
+        if(!whole){
+            records.resize(i);
+            break;
+        }
+        i = end - 1;
+    }
+
+    struct stat info;
+    off_t good = (off_t)(records.size() * sizeof(journal_record));
+    if(stat(path.c_str(),&info) == 0 && info.st_size != good){
+        cerr<<"Journal tail dropped"<<endl;
+        if(truncate(path.c_str(),good) != 0) {cerr<<"Cannot write journal"<<endl;}
+    }
+    return records;
+}
+
+};
+
+// segment_tree whose every write is journaled , reopening the same paths after a crash rebuilds the tree
+// from the last compacted snapshot plus every durable journal record
+//
+// a range add is relative , so replay must apply every record exactly once : the snapshot keeps the sequence of the
+// last record it holds and replay skips the records up to it , an insert goes back into the slot it was given
+// compaction relies on that , the new snapshot is in place before the journal is cut , a crash in between is harmless
+class journaled_leaderboard {
+
+private:
+
+segment_tree* tree ;
+string log_path ;
+string snapshot_path ;
+write_ahead_log* log ;
+int group_size ;
+int group_delay_ms ;
+long long last_sequence ; // sequence of the last write , the next one gets last_sequence + 1
+
+void replay(){
+    last_sequence = 0;
+    {
+        struct stat info;
+        if(stat(snapshot_path.c_str(),&info) == 0){
+            mapped_leaderboard snapshot(snapshot_path);
+            snapshot.restore_into(*tree);
+            last_sequence = snapshot.journal_sequence();
+        }
+    }
+
+    vector<journal_record> records = write_ahead_log :: read_all(log_path);
+    for(size_t i = 0; i < records.size(); i++){
+        const journal_record &r = records[i];
+        size_t members = r.op == journal_batch ? (size_t)r.player_id : 0;
+        if(r.sequence > last_sequence){ // the older ones are in the snapshot already
+            player_data p(r.score,r.player_id,r.finish_time);
+            if(r.op == journal_insert) {tree->insert_at(p);}
+            else if(r.op == journal_update) {tree->update_player_data(p);}
+            else if(r.op == journal_remove) {tree->remove_player(r.player_id);}
+            else if(r.op == journal_range_add) {tree->add_score_range(r.player_id,r.finish_time,r.score);}
+            else {
+                vector<player_data> batch;
+                for(size_t j = i + 1; j <= i + members; j++){
+                    batch.push_back(player_data(records[j].score,records[j].player_id,records[j].finish_time));
+                }
+                tree->apply_updates(batch);
+            }
+            last_sequence = r.sequence;
+        }
+        i += members;
+    }
+    tree->sync_indexes();
+}
+
+void append(journal_op op, int score, int player_id, int finish_time){
+    journal_record r(op,score,player_id,finish_time,++last_sequence);
+    log->append(&r,1);
+}
+
+static bool fsync_path(const string &path, int flags){
+    int fd = open(path.c_str(),flags);
+    if(fd < 0) {return false;}
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+static string directory_of(const string &path){
+    size_t slash = path.rfind('/');
+    return slash == string::npos ? string(".") : path.substr(0,slash + 1);
+}
+
+public:
+
+journaled_leaderboard(int size, const string &log_path, const string &snapshot_path,
+                      int group_size = 1024, int group_delay_ms = 5) :
+tree(new segment_tree(size)),log_path(log_path),snapshot_path(snapshot_path),log(0),
+group_size(group_size),group_delay_ms(group_delay_ms),last_sequence(0)
+{
+    replay();
+    log = new write_ahead_log(log_path,group_size,group_delay_ms);
+}
+
+~journaled_leaderboard(){
+    delete log;
+    delete tree;
+}
+
+journaled_leaderboard(const journaled_leaderboard &) = delete;
+journaled_leaderboard& operator=(const journaled_leaderboard &) = delete;
+
+// the tree changes first , the record is durable after the group it lands in is flushed (or after sync)
+// returns the ID the player got , -1 when the board is full and nothing was logged
+int insert_into_tree(player_data p){
+    int id = tree->insert_into_tree(p);
+    if(id == -1) {return -1;}
+    append(journal_insert,p.score,id,p.finish_time);
+    return id;
+}
+
+bool update_player_data(player_data new_player_data){
+    if(!tree->update_player_data(new_player_data)) {return false;}
+    append(journal_update,new_player_data.score,new_player_data.player_id,new_player_data.finish_time);
+    return true;
+}
+
+bool remove_player(int player_id){
+    if(!tree->remove_player(player_id)) {return false;}
+    append(journal_remove,0,player_id,0);
+    return true;
+}
+
+// one relative record , replay applies it once thanks to the sequence numbers
+bool add_score_range(int begin_id, int end_id, int delta){
+    if(!tree->add_score_range(begin_id,end_id,delta)) {return false;}
+    append(journal_range_add,delta,begin_id,end_id);
+    return true;
+}
+
+// the updates that went through are logged behind one journal_batch record , replay applies them together or ,
+// when the crash cut the batch short , not at all
+vector<bool> apply_updates(const vector<player_data> &updates){
+    vector<bool> success = tree->apply_updates(updates);
+    vector<journal_record> records(1);
+    for(size_t i = 0; i < updates.size(); i++){
+        if(!success[i]) {continue;}
+        records.push_back(journal_record(journal_update,updates[i].score,updates[i].player_id,updates[i].finish_time,
+                                         last_sequence + 1));
+    }
+    if(records.size() == 1) {return success;}
+    records[0] = journal_record(journal_batch,0,(int)records.size() - 1,0,++last_sequence);
+    log->append(records.data(),records.size());
+    return success;
+}
+
+bool sync(){
+    return log->sync();
+}
+
+// folds the journal into a fresh snapshot and starts an empty journal
+bool compact(){
+    if(!log->sync()) {return false;}
+
+    string temporary = snapshot_path + ".tmp";
+    if(!save_snapshot(*tree,temporary,last_sequence) || !fsync_path(temporary,O_RDONLY) ||
+       rename(temporary.c_str(),snapshot_path.c_str()) != 0 || !fsync_path(directory_of(snapshot_path),O_RDONLY)){
+        cerr<<"Cannot write snapshot "<<snapshot_path<<endl;
+        return false;
+    }
+
+    delete log;
+    log = 0;
+    bool ok = truncate(log_path.c_str(),0) == 0;
+    if(!ok) {cerr<<"Cannot write journal"<<endl;}
+    log = new write_ahead_log(log_path,group_size,group_delay_ms);
+    return ok;
+}
+
+player_data query_the_tree_by_id(int begin_id, int end_id){
+    return tree->query_the_tree_by_id(begin_id,end_id);
+}
+
+player_data query_the_tree_by_time(int start_time, int finish_time){
+    return tree->query_the_tree_by_time(start_time,finish_time);
+}
+
+// the two reads that write to the tree (pushing tags down , building the combined index) , nothing to journal
+vector<player_data> top_k_by_id(int begin_id, int end_id, int k){
+    return tree->top_k_by_id(begin_id,end_id,k);
+}
+
+player_data query_by_id_and_time(int begin_id, int end_id, int start_time, int finish_time){
+    return tree->query_by_id_and_time(begin_id,end_id,start_time,finish_time);
+}
+
+// moves the players of the range adds so far in the time and rank indexes , see segment_tree::sync_indexes
+void sync_indexes(){
+    tree->sync_indexes();
+}
+
+// the rest of the read API , every write goes through this class so that it is journaled
+const segment_tree& board() const {
+    return *tree;
+}
+
+};